@@ -0,0 +1,107 @@
+#include "gc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static size_t object_size(GCObject* o) {
+    return sizeof(StringObj) + ((StringObj*)o)->length + 1;
+}
+
+GCObject* gc_new(VM* vm, ValueType type, size_t size) {
+    Heap* h = &vm->heap;
+    h->bytes += size;
+    if (h->bytes > h->peak_bytes) h->peak_bytes = h->bytes;
+#ifdef NIRVANA_GC_STRESS
+    gc_collect(vm);
+#else
+    if (h->bytes > h->next_gc) gc_collect(vm);
+#endif
+    GCObject* o = malloc(size);
+    if (!o) {
+        fprintf(stderr, "Error: Alokasi memori gagal (heap %zu byte)\n", h->bytes);
+        exit(1);
+    }
+    o->type = (uint8_t)type;
+    o->marked = 0;
+    o->next = h->objects;
+    h->objects = o;
+    h->objects_allocated++;
+    return o;
+}
+
+// === MARK ===
+
+static void mark_value(Value* v) {
+    if (VAL_TYPE(*v) == VAL_STRING && AS_STRING(*v)) STRING_OBJ(AS_STRING(*v))->gc.marked = 1;
+}
+
+static void mark_roots(VM* vm) {
+    // Seluruh stack, bukan hanya jendela frame aktif: slot di atas frame
+    // teratas bisa berisi nilai lama, dan menandainya lebih murah daripada
+    // menjaga agar nilai itu tidak pernah dibaca lagi.
+    for (int i = 0; i < vm->stack_size; i++) mark_value(&vm->stack[i]);
+    GlobalTable* g = &vm->globals;
+    for (int i = 0; i < g->count; i++) {
+        if (g->defined[i]) mark_value(&g->values[i]);
+    }
+    for (int f = 0; f < vm->num_functions; f++) {
+        FunctionProto* fn = &vm->functions[f];
+        for (int i = 0; i < fn->num_constants; i++) mark_value(&fn->constants[i]);
+    }
+}
+
+// === SWEEP ===
+
+static void free_object(Heap* h, GCObject* o) {
+    size_t size = object_size(o);
+    h->bytes -= size;
+    h->bytes_freed += size;
+    h->objects_freed++;
+    free(o);
+}
+
+static void sweep(Heap* h) {
+    GCObject** link = &h->objects;
+    while (*link) {
+        GCObject* o = *link;
+        if (o->marked) {
+            o->marked = 0;
+            link = &o->next;
+        } else {
+            *link = o->next;
+            free_object(h, o);
+        }
+    }
+}
+
+void gc_collect(VM* vm) {
+    Heap* h = &vm->heap;
+    clock_t start = clock();
+    mark_roots(vm);
+    sweep(h);
+    h->next_gc = h->bytes * GC_HEAP_GROW;
+    if (h->next_gc < GC_MIN_HEAP) h->next_gc = GC_MIN_HEAP;
+
+    double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    h->collections++;
+    h->pause_total_ms += ms;
+    if (ms > h->pause_max_ms) h->pause_max_ms = ms;
+}
+
+void gc_free_all(VM* vm) {
+    Heap* h = &vm->heap;
+    while (h->objects) {
+        GCObject* o = h->objects;
+        h->objects = o->next;
+        free_object(h, o);
+    }
+}
+
+void gc_print_stats(VM* vm) {
+    Heap* h = &vm->heap;
+    fprintf(stderr, "[gc] %d koleksi, jeda total %.3f ms, maks %.3f ms\n",
+            h->collections, h->pause_total_ms, h->pause_max_ms);
+    fprintf(stderr, "[gc] %zu objek dialokasi, %zu dibebaskan (%zu KB), heap %zu KB, puncak %zu KB\n",
+            h->objects_allocated, h->objects_freed, h->bytes_freed / 1024,
+            h->bytes / 1024, h->peak_bytes / 1024);
+}
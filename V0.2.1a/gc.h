@@ -0,0 +1,30 @@
+#ifndef GC_H
+#define GC_H
+
+#include "vm.h"
+#include <stddef.h>
+
+// Garbage collector mark-and-sweep presisi untuk string. Root: seluruh
+// stack register, nilai global yang sudah didefinisikan, dan tabel
+// konstanta setiap fungsi. Koleksi hanya terjadi di dalam gc_new(),
+// sebelum objek baru ditautkan, jadi nilai yang masih dipakai harus
+// sudah tersimpan di salah satu root sebelum alokasi berikutnya.
+//
+// -DNIRVANA_GC_STATS mencetak statistik ke stderr saat VM dihancurkan,
+// -DNIRVANA_GC_STRESS mengoleksi di setiap alokasi (menguji root).
+// GC_MIN_HEAP dan GC_HEAP_GROW bisa ditimpa dengan -D untuk tuning.
+#ifndef GC_MIN_HEAP
+#define GC_MIN_HEAP (1024 * 1024)
+#endif
+#ifndef GC_HEAP_GROW
+#define GC_HEAP_GROW 2
+#endif
+
+// Objek baru `size` byte (termasuk header), sudah tertaut ke heap
+GCObject* gc_new(VM* vm, ValueType type, size_t size);
+void gc_collect(VM* vm);
+// Bebaskan semua objek (vm_destroy)
+void gc_free_all(VM* vm);
+void gc_print_stats(VM* vm);
+
+#endif // GC_H
@@ -41,7 +41,7 @@ static TokenType check_keyword(const char* str, int len) {
     if (len == 4 && strncmp(str, "maka", 4) == 0) return TOKEN_MAKA;
     if (len == 4 && strncmp(str, "lain", 4) == 0) return TOKEN_LAIN;
     if (len == 6 && strncmp(str, "selama", 6) == 0) return TOKEN_SELAMA;
-    if (len == 7 && strncmp(str, "fungsi", 7) == 0) return TOKEN_FUNGSI;
+    if (len == 6 && strncmp(str, "fungsi", 6) == 0) return TOKEN_FUNGSI;
     if (len == 10 && strncmp(str, "kembalikan", 10) == 0) return TOKEN_KEMBALI;
     if (len == 5 && strncmp(str, "benar", 5) == 0) return TOKEN_BENAR;
     if (len == 5 && strncmp(str, "salah", 5) == 0) return TOKEN_SALAH;
@@ -176,7 +176,10 @@ Token** lex(const char* input, int* token_count) {
             }
             
             // Skip empty lines and comments
-            if (*current == '\n' || *current == '#') {
+            if (*current == '#') {
+                while (*current != '\n' && *current != '\0') { current++; col++; }
+            }
+            if (*current == '\n' || *current == '\0') {
                 if (*current == '\n') {
                     line++;
                     col = 1;
@@ -7,6 +7,7 @@
 #include "lexer.h"
 #include "parser.h"
 #include "vm.h"
+#include "intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -207,5 +208,6 @@ int main(int argc, char* argv[]) {
         printf("\nUse -r for REPL or provide filename\n");
     }
     
+    intern_free_all();
     return 0;
 }
@@ -5,6 +5,7 @@
 
 #include "parser.h"
 #include "lexer.h"
+#include "intern.h"
 
 static Token** tokens;
 static int token_count;
@@ -124,7 +125,7 @@ static ASTNode* parse_primary(void) {
     // Identifier atau function call (termasuk 'cetak')
     if (check(TOKEN_NAMA) || check(TOKEN_CETAK)) {
         advance();
-        char* name = my_strdup(t->lexeme);
+        const char* name = intern_cstr(t->lexeme);
         
         // Function call
         if (match(TOKEN_BUKA_KURUNG)) {
@@ -446,25 +447,28 @@ static ASTNode* parse_function(void) {
     consume(TOKEN_BUKA_KURUNG, "Expected '(' after function name");
     
     ASTNode* node = make_node(AST_FUNCTION);
-    node->function.name = my_strdup(name->lexeme);
+    node->function.name = intern_cstr(name->lexeme);
     node->function.param_count = 0;
     node->function.params = NULL;
     
     if (!check(TOKEN_TUTUP_KURUNG)) {
         int capacity = 4;
-        node->function.params = malloc(sizeof(char*) * capacity);
+        node->function.params = malloc(sizeof(const char*) * capacity);
         do {
             Token* param = consume(TOKEN_NAMA, "Expected parameter name");
             if (node->function.param_count >= capacity) {
                 capacity *= 2;
-                node->function.params = realloc(node->function.params, sizeof(char*) * capacity);
+                node->function.params = realloc(node->function.params, sizeof(const char*) * capacity);
             }
-            node->function.params[node->function.param_count++] = my_strdup(param->lexeme);
+            node->function.params[node->function.param_count++] = intern_cstr(param->lexeme);
         } while (match(TOKEN_KOMA));
     }
     
     consume(TOKEN_TUTUP_KURUNG, "Expected ')' after parameters");
     
+    // Optional 'maka' keyword, seperti jika
+    if (check(TOKEN_MAKA)) advance();
+    
     skip_whitespace();
     node->function.body = parse_block();
     
@@ -523,7 +527,7 @@ static ASTNode* parse_statement(void) {
         advance(); // consume =
         
         ASTNode* node = make_node(AST_ASSIGN);
-        node->assign.name = my_strdup(name->lexeme);
+        node->assign.name = intern_cstr(name->lexeme);
         node->assign.value = parse_expression();
         return node;
     }
@@ -652,7 +656,6 @@ void free_ast(ASTNode* node) {
     if (!node) return;
     switch (node->type) {
         case AST_STRING: free(node->string); break;
-        case AST_IDENTIFIER: free(node->name); break;
         case AST_BINARY:
             free_ast(node->binary.left);
             free_ast(node->binary.right);
@@ -661,11 +664,9 @@ void free_ast(ASTNode* node) {
             free_ast(node->unary.operand);
             break;
         case AST_ASSIGN:
-            free(node->assign.name);
             free_ast(node->assign.value);
             break;
         case AST_CALL:
-            free(node->call.name);
             for (int i = 0; i < node->call.arg_count; i++) free_ast(node->call.args[i]);
             free(node->call.args);
             break;
@@ -682,6 +683,13 @@ void free_ast(ASTNode* node) {
             free_ast(node->while_stmt.condition);
             free_ast(node->while_stmt.body);
             break;
+        case AST_FUNCTION:
+            free(node->function.params);    // nama parameter milik tabel intern
+            free_ast(node->function.body);
+            break;
+        case AST_RETURN:
+            free_ast(node->return_stmt.value);
+            break;
         default: break;
     }
     free(node);
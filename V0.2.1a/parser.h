@@ -44,7 +44,7 @@ typedef struct ASTNode {
         double float_num;   // NEW
         char* string;       // NEW
         int boolean;        // NEW
-        char* name;         // identifier
+        const char* name;   // identifier (simbol intern, intern.h)
         
         // Binary expression
         struct {
@@ -61,13 +61,13 @@ typedef struct ASTNode {
         
         // Assignment
         struct {
-            char *name;
+            const char *name;
             struct ASTNode *value;
         } assign;
         
         // Function call
         struct {
-            char *name;
+            const char *name;
             struct ASTNode **args;
             int arg_count;
         } call;
@@ -99,8 +99,8 @@ typedef struct ASTNode {
         
         // Function definition (NEW)
         struct {
-            char *name;
-            char **params;
+            const char *name;
+            const char **params;
             int param_count;
             struct ASTNode *body;
         } function;
@@ -112,7 +112,7 @@ typedef struct ASTNode {
         
         // Variable declaration (NEW)
         struct {
-            char *name;
+            const char *name;
             struct ASTNode *initializer;
         } var_decl;
     };
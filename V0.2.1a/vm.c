@@ -1,4 +1,7 @@
+#define _POSIX_C_SOURCE 200809L
 #include "vm.h"
+#include "intern.h"
+#include "gc.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,6 +9,58 @@
 
 // === VALUE OPERATIONS ===
 
+// Salin `len` byte `s` ke objek string baru di heap GC; hasilnya
+// menunjuk karakter
+static char* new_string(VM* vm, const char* s, size_t len) {
+    StringObj* o = (StringObj*)gc_new(vm, VAL_STRING, sizeof(StringObj) + len + 1);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    o->length = (uint32_t)len;
+    o->hash = h;
+    char* chars = (char*)(o + 1);
+    memcpy(chars, s, len);
+    chars[len] = '\0';
+    return chars;
+}
+
+static inline int strings_equal(const char* a, const char* b) {
+    if (a == b) return 1;
+    StringObj* x = STRING_OBJ(a);
+    StringObj* y = STRING_OBJ(b);
+    if (x->length != y->length || x->hash != y->hash) return 0;
+    return memcmp(a, b, x->length) == 0;
+}
+
+#ifdef NIRVANA_NAN_BOXING
+static Value make_nil(void) {
+    return NB_BOX(VAL_NIL, 0);
+}
+
+static Value make_bool(int b) {
+    return NB_BOX(VAL_BOOL, b != 0);
+}
+
+static Value make_float(double f) {
+    union { double f; uint64_t bits; } u = { f };
+    if (f != f) u.bits = 0x7FF8000000000000ULL;   // NaN kanonik, di luar ruang tag
+    return u.bits;
+}
+
+static Value make_int(int64_t i) {
+    // Di luar 48 bit tidak muat di payload: turunkan ke float.
+    if (i < NB_INT_MIN || i > NB_INT_MAX) return make_float((double)i);
+    return NB_BOX(VAL_INT, i);
+}
+
+static Value make_string(VM* vm, const char* s, size_t len) {
+    return NB_BOX(VAL_STRING, (uintptr_t)new_string(vm, s, len));
+}
+
+static Value make_function(int idx) {
+    return NB_BOX(VAL_FUNCTION, idx);
+}
+
+#else
 static Value make_nil(void) {
     Value v = {VAL_NIL, {0}};
     return v;
@@ -32,39 +87,41 @@ static Value make_float(double f) {
     return v;
 }
 
-static Value make_string(const char* s) {
+static Value make_string(VM* vm, const char* s, size_t len) {
     Value v;
     v.type = VAL_STRING;
-    v.s = strdup(s);
+    v.s = new_string(vm, s, len);
     return v;
 }
 
-static void free_value(Value* v) {
-    if (v->type == VAL_STRING && v->s) {
-        free(v->s);
-        v->s = NULL;
-    }
+static Value make_function(int idx) {
+    Value v;
+    v.type = VAL_FUNCTION;
+    v.func.idx = idx;
+    v.func.num_upvals = 0;
+    return v;
 }
+#endif
 
 static void print_value(Value* v) {
-    switch (v->type) {
+    switch (VAL_TYPE(*v)) {
         case VAL_NIL: printf("nil"); break;
-        case VAL_BOOL: printf("%s", v->i ? "true" : "false"); break;
-        case VAL_INT: printf("%ld", v->i); break;
-        case VAL_FLOAT: printf("%g", v->f); break;
-        case VAL_STRING: printf("%s", v->s); break;
+        case VAL_BOOL: printf("%s", AS_BOOL(*v) ? "true" : "false"); break;
+        case VAL_INT: printf("%ld", AS_INT(*v)); break;
+        case VAL_FLOAT: printf("%g", AS_FLOAT(*v)); break;
+        case VAL_STRING: printf("%s", AS_STRING(*v)); break;
         default: printf("<object>"); break;
     }
 }
 
 // Type coercion for arithmetic
 static int to_number(Value* v, double* out) {
-    switch (v->type) {
-        case VAL_INT: *out = (double)v->i; return 1;
-        case VAL_FLOAT: *out = v->f; return 1;
+    switch (VAL_TYPE(*v)) {
+        case VAL_INT: *out = (double)AS_INT(*v); return 1;
+        case VAL_FLOAT: *out = AS_FLOAT(*v); return 1;
         case VAL_STRING: {
             char* end;
-            *out = strtod(v->s, &end);
+            *out = strtod(AS_STRING(*v), &end);
             return *end == '\0';
         }
         default: return 0;
@@ -72,10 +129,10 @@ static int to_number(Value* v, double* out) {
 }
 
 static int is_truthy(Value* v) {
-    if (v->type == VAL_NIL) return 0;
-    if (v->type == VAL_BOOL) return v->i != 0;
-    if (v->type == VAL_INT) return v->i != 0;
-    if (v->type == VAL_FLOAT) return v->f != 0.0;
+    if (VAL_TYPE(*v) == VAL_NIL) return 0;
+    if (VAL_TYPE(*v) == VAL_BOOL) return AS_BOOL(*v);
+    if (VAL_TYPE(*v) == VAL_INT) return AS_INT(*v) != 0;
+    if (VAL_TYPE(*v) == VAL_FLOAT) return AS_FLOAT(*v) != 0.0;
     return 1; // string and others are truthy
 }
 
@@ -92,50 +149,146 @@ VM* vm_create(void) {
     vm->num_functions = 0;
     vm->current_func = -1;
     vm->pc = 0;
-    vm->call_depth = 0;
-    vm->num_globals = 0;
-    vm->string_count = 0;
+    vm->frame_count = 0;
+    vm->heap.next_gc = GC_MIN_HEAP;
     
     return vm;
 }
 
+// Stack register cukup untuk `needed` slot. realloc bisa memindahkan
+// stack, jadi pemanggil harus menghitung ulang pointer base sesudahnya.
+static void ensure_stack(VM* vm, int needed) {
+    if (needed <= vm->stack_size) return;
+    int size = vm->stack_size ? vm->stack_size : MAX_REGISTERS;
+    while (size < needed) size *= 2;
+    vm->stack = realloc(vm->stack, sizeof(Value) * size);
+    if (!vm->stack) {
+        fprintf(stderr, "Error: Alokasi memori gagal untuk stack register\n");
+        exit(1);
+    }
+    // calloc/realloc tidak memberi nil: dengan NaN-boxing bit nol = 0.0
+    for (int i = vm->stack_size; i < size; i++) vm->stack[i] = make_nil();
+    vm->stack_size = size;
+}
+
+static CallFrame* push_frame(VM* vm) {
+    if (vm->frame_count >= vm->frame_capacity) {
+        vm->frame_capacity = vm->frame_capacity ? vm->frame_capacity * 2 : 64;
+        vm->frames = realloc(vm->frames, sizeof(CallFrame) * vm->frame_capacity);
+        if (!vm->frames) {
+            fprintf(stderr, "Error: Alokasi memori gagal untuk call stack\n");
+            exit(1);
+        }
+    }
+    return &vm->frames[vm->frame_count++];
+}
+
 void vm_destroy(VM* vm) {
     if (!vm) return;
     
     // Free functions
     for (int i = 0; i < vm->num_functions; i++) {
         FunctionProto* fn = &vm->functions[i];
-        free(fn->name);
         free(fn->code);
         free(fn->constants);
     }
     free(vm->functions);
+    free(vm->stack);
+    free(vm->frames);
     
-    // Free globals
-    for (int i = 0; i < vm->num_globals; i++) {
-        free(vm->globals[i].name);
-        free_value(&vm->globals[i].value);
-    }
+    // Free globals (string di dalamnya milik heap GC)
+    GlobalTable* g = &vm->globals;
+    free(g->names);
+    free(g->values);
+    free(g->defined);
+    free(g->index);
+    free(g->order);
     
-    // Free string pool
-    for (int i = 0; i < vm->string_count; i++) {
-        free(vm->string_pool[i]);
-    }
+#ifdef NIRVANA_GC_STATS
+    gc_print_stats(vm);
+#endif
+    gc_free_all(vm);
     
     free(vm);
 }
 
+// === GLOBALS ===
+
+static uint32_t symbol_hash(const char* sym) {
+    // Simbol intern unik per pointer: cukup acak alamatnya
+    return (uint32_t)(((uintptr_t)sym >> 3) * 2654435761u);
+}
+
+static void index_insert(GlobalTable* g, int slot) {
+    uint32_t mask = (uint32_t)g->index_capacity - 1;
+    uint32_t i = symbol_hash(g->names[slot]) & mask;
+    while (g->index[i] >= 0) i = (i + 1) & mask;
+    g->index[i] = slot;
+}
+
+static void index_grow(GlobalTable* g) {
+    free(g->index);
+    g->index_capacity = g->index_capacity ? g->index_capacity * 2 : 64;
+    g->index = malloc(sizeof(int) * g->index_capacity);
+    if (!g->index) {
+        fprintf(stderr, "Error: Alokasi memori gagal untuk tabel global\n");
+        exit(1);
+    }
+    for (int i = 0; i < g->index_capacity; i++) g->index[i] = -1;
+    for (int slot = 0; slot < g->count; slot++) index_insert(g, slot);
+}
+
+int vm_global_slot(VM* vm, const char* name) {
+    GlobalTable* g = &vm->globals;
+    if (g->index_capacity) {
+        uint32_t mask = (uint32_t)g->index_capacity - 1;
+        for (uint32_t i = symbol_hash(name) & mask; g->index[i] >= 0; i = (i + 1) & mask) {
+            if (g->names[g->index[i]] == name) return g->index[i];
+        }
+    }
+
+    if (g->count > 0xFFFF) {
+        fprintf(stderr, "Error: Terlalu banyak variabel global (maks 65536)\n");
+        exit(1);
+    }
+    if (g->count >= g->capacity) {
+        g->capacity = g->capacity ? g->capacity * 2 : 64;
+        g->names = realloc(g->names, sizeof(const char*) * g->capacity);
+        g->values = realloc(g->values, sizeof(Value) * g->capacity);
+        g->defined = realloc(g->defined, g->capacity);
+        g->order = realloc(g->order, sizeof(int) * g->capacity);
+        if (!g->names || !g->values || !g->defined || !g->order) {
+            fprintf(stderr, "Error: Alokasi memori gagal untuk tabel global\n");
+            exit(1);
+        }
+    }
+    int slot = g->count++;
+    g->names[slot] = name;
+    g->values[slot] = make_nil();
+    g->defined[slot] = 0;
+    if (g->count * 2 > g->index_capacity) index_grow(g);
+    else index_insert(g, slot);
+    return slot;
+}
+
 // === COMPILER ===
 
+#define MAX_LOCALS 64
+
+// Satu Compiler per fungsi. Parameter dan lokal (nama yang di-assign di
+// badan fungsi, seperti resolver V0.4) menempati R0..num_locals-1;
+// temporary di atasnya hidup sampai akhir statement. Program utama tidak
+// punya lokal: semua namanya global.
 typedef struct {
     VM* vm;
     FunctionProto* fn;
     int next_reg;
+    int max_reg;            // register tertinggi + 1 -> fn->max_stack
     int num_locals;
     struct {
-        char* name;
+        const char* name;   // simbol intern
         int reg;
-    } locals[64];
+    } locals[MAX_LOCALS];
 } Compiler;
 
 static Compiler* current_compiler = NULL;
@@ -145,7 +298,9 @@ static int alloc_reg(Compiler* comp) {
         fprintf(stderr, "Error: Out of registers\n");
         exit(1);
     }
-    return comp->next_reg++;
+    int reg = comp->next_reg++;
+    if (comp->next_reg > comp->max_reg) comp->max_reg = comp->next_reg;
+    return reg;
 }
 
 static void free_reg(Compiler* comp) {
@@ -157,13 +312,11 @@ static int add_constant(Compiler* comp, Value val) {
     
     // Check for existing constant
     for (int i = 0; i < fn->num_constants; i++) {
-        if (fn->constants[i].type != val.type) continue;
-        if (val.type == VAL_INT && fn->constants[i].i == val.i) return i;
-        if (val.type == VAL_FLOAT && fn->constants[i].f == val.f) return i;
-        if (val.type == VAL_STRING && strcmp(fn->constants[i].s, val.s) == 0) {
-            free_value(&val); // Don't leak
-            return i;
-        }
+        if (VAL_TYPE(fn->constants[i]) != VAL_TYPE(val)) continue;
+        if (VAL_TYPE(val) == VAL_INT && AS_INT(fn->constants[i]) == AS_INT(val)) return i;
+        if (VAL_TYPE(val) == VAL_FLOAT && AS_FLOAT(fn->constants[i]) == AS_FLOAT(val)) return i;
+        // String duplikat tidak dibebaskan di sini: jadi sampah untuk GC
+        if (VAL_TYPE(val) == VAL_STRING && strings_equal(AS_STRING(fn->constants[i]), AS_STRING(val))) return i;
     }
     
     int idx = fn->num_constants++;
@@ -181,9 +334,17 @@ static void emit(Compiler* comp, Instruction inst) {
     fn->code[fn->code_size++] = inst;
 }
 
+// Offset sBx relatif terhadap instruksi setelah lompatan (VM menaikkan
+// pc setelah setiap instruksi). Register A dan opcode dipertahankan.
+static void patch_jump(Compiler* comp, int at, int target) {
+    Instruction inst = comp->fn->code[at];
+    int offset = target - at - 1;
+    comp->fn->code[at] = MAKE_ABx(GET_OP(inst), GET_A(inst), offset & 0xFFFF);
+}
+
 static int find_local(Compiler* comp, const char* name) {
     for (int i = comp->num_locals - 1; i >= 0; i--) {
-        if (strcmp(comp->locals[i].name, name) == 0) {
+        if (comp->locals[i].name == name) {
             return comp->locals[i].reg;
         }
     }
@@ -191,8 +352,13 @@ static int find_local(Compiler* comp, const char* name) {
 }
 
 static int add_local(Compiler* comp, const char* name) {
+    if (comp->num_locals >= MAX_LOCALS) {
+        fprintf(stderr, "Error: Terlalu banyak variabel lokal di fungsi '%s' (maks %d)\n",
+                comp->fn->name, MAX_LOCALS);
+        exit(1);
+    }
     int reg = alloc_reg(comp);
-    comp->locals[comp->num_locals].name = strdup(name);
+    comp->locals[comp->num_locals].name = name;
     comp->locals[comp->num_locals].reg = reg;
     comp->num_locals++;
     return reg;
@@ -251,6 +417,31 @@ static int compile_unary(Compiler* comp, ASTNode* node) {
     return result;
 }
 
+// Panggilan fungsi (selain cetak). R(A) = fungsi, argumen ditaruh
+// langsung di R(A+1).. yang menjadi R0.. callee; temporary tiap argumen
+// langsung dibuang. `op` adalah OP_CALL atau OP_TAILCALL.
+static int compile_call(Compiler* comp, ASTNode* node, OpCode op) {
+    int func_reg = alloc_reg(comp);
+    int local = find_local(comp, node->call.name);
+    if (local >= 0) {
+        emit(comp, MAKE_ABC(OP_MOVE, func_reg, local, 0));
+    } else {
+        emit(comp, MAKE_ABx(OP_GETGLOBAL, func_reg, vm_global_slot(comp->vm, node->call.name)));
+    }
+    for (int i = 0; i < node->call.arg_count; i++) {
+        int target = comp->next_reg;
+        int reg = compile_expr(comp, node->call.args[i]);
+        comp->next_reg = target;
+        alloc_reg(comp);
+        if (reg != target) {
+            emit(comp, MAKE_ABC(OP_MOVE, target, reg, 0));
+        }
+    }
+    emit(comp, MAKE_ABC(op, func_reg, node->call.arg_count + 1, 0));
+    comp->next_reg = func_reg + 1;
+    return func_reg;
+}
+
 static int compile_expr(Compiler* comp, ASTNode* node) {
     switch (node->type) {
         case AST_NUMBER: {
@@ -269,7 +460,7 @@ static int compile_expr(Compiler* comp, ASTNode* node) {
         
         case AST_STRING: {
             int reg = alloc_reg(comp);
-            int k = add_constant(comp, make_string(node->string));
+            int k = add_constant(comp, make_string(comp->vm, node->string, strlen(node->string)));
             emit(comp, MAKE_ABx(OP_LOADK, reg, k));
             return reg;
         }
@@ -293,8 +484,7 @@ static int compile_expr(Compiler* comp, ASTNode* node) {
             
             // Global variable
             int reg = alloc_reg(comp);
-            int k = add_constant(comp, make_string(node->name));
-            emit(comp, MAKE_ABx(OP_GETGLOBAL, reg, k));
+            emit(comp, MAKE_ABx(OP_GETGLOBAL, reg, vm_global_slot(comp->vm, node->name)));
             return reg;
         }
         
@@ -305,36 +495,25 @@ static int compile_expr(Compiler* comp, ASTNode* node) {
             return compile_unary(comp, node);
             
         case AST_CALL: {
-            // Compile arguments
+            if (node->call.name != intern_cstr("cetak")) {
+                return compile_call(comp, node, OP_CALL);
+            }
+            
+            // Built-in cetak: OP_PRINT mencetak argumen pertama
             int arg_regs[16];
             for (int i = 0; i < node->call.arg_count && i < 16; i++) {
                 arg_regs[i] = compile_expr(comp, node->call.args[i]);
             }
             
-            // Move arguments to consecutive registers
             int base = alloc_reg(comp);
-            for (int i = 0; i < node->call.arg_count && i < 16; i++) {
-                if (arg_regs[i] != base + i) {
-                    emit(comp, MAKE_ABC(OP_MOVE, base + i, arg_regs[i], 0));
-                }
-            }
-            
-            // Special handling for built-in functions
-            if (strcmp(node->call.name, "cetak") == 0) {
-                emit(comp, MAKE_ABC(OP_PRINT, base, 0, 0));
-                free_reg(comp); // Return nil
-                int result = alloc_reg(comp);
-                emit(comp, MAKE_ABC(OP_LOADNIL, result, 0, 0));
-                return result;
+            if (node->call.arg_count > 0 && arg_regs[0] != base) {
+                emit(comp, MAKE_ABC(OP_MOVE, base, arg_regs[0], 0));
             }
-            
-            // Regular function call
-            int func_reg = alloc_reg(comp);
-            int k = add_constant(comp, make_string(node->call.name));
-            emit(comp, MAKE_ABx(OP_GETGLOBAL, func_reg, k));
-            emit(comp, MAKE_ABC(OP_CALL, func_reg, node->call.arg_count + 1, 0));
-            
-            return func_reg;
+            emit(comp, MAKE_ABC(OP_PRINT, base, 0, 0));
+            free_reg(comp); // Return nil
+            int result = alloc_reg(comp);
+            emit(comp, MAKE_ABC(OP_LOADNIL, result, 0, 0));
+            return result;
         }
         
         default:
@@ -343,11 +522,73 @@ static int compile_expr(Compiler* comp, ASTNode* node) {
     }
 }
 
+// Nama yang di-assign di badan fungsi menjadi lokal (tanpa masuk ke
+// fungsi bersarang), sama dengan declare_locals() resolver V0.4
+static void declare_locals(Compiler* comp, ASTNode* node) {
+    if (!node) return;
+    switch (node->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < node->block.count; i++) {
+                declare_locals(comp, node->block.statements[i]);
+            }
+            break;
+        case AST_ASSIGN:
+            if (find_local(comp, node->assign.name) < 0) add_local(comp, node->assign.name);
+            break;
+        case AST_FUNCTION:
+            if (find_local(comp, node->function.name) < 0) add_local(comp, node->function.name);
+            break;
+        case AST_IF:
+            declare_locals(comp, node->if_stmt.then_branch);
+            declare_locals(comp, node->if_stmt.else_branch);
+            break;
+        case AST_WHILE:
+            declare_locals(comp, node->while_stmt.body);
+            break;
+        default:
+            break;
+    }
+}
+
+// Kompilasi badan fungsi ke proto baru; mengembalikan indeksnya.
+// v0.2.1a belum punya closure: nama bebas di badan fungsi dibaca dari
+// global, termasuk lokal fungsi pembungkus.
+static int compile_function(Compiler* outer, ASTNode* node) {
+    int idx = vm_add_function(outer->vm, node->function.name);
+    FunctionProto* fn = &outer->vm->functions[idx];
+    fn->num_params = node->function.param_count;
+    
+    Compiler comp = {
+        .vm = outer->vm,
+        .fn = fn,
+        .next_reg = 0,
+        .max_reg = 0,
+        .num_locals = 0
+    };
+    for (int i = 0; i < node->function.param_count; i++) {
+        add_local(&comp, node->function.params[i]);
+    }
+    declare_locals(&comp, node->function.body);
+    fn->num_locals = comp.num_locals;
+    
+    compile_stmt(&comp, node->function.body);
+    
+    // Jatuh dari akhir badan: kembalikan nil
+    int reg = alloc_reg(&comp);
+    emit(&comp, MAKE_ABC(OP_LOADNIL, reg, 0, 0));
+    emit(&comp, MAKE_ABC(OP_RETURN, reg, 0, 0));
+    fn->max_stack = comp.max_reg;
+    return idx;
+}
+
 static void compile_stmt(Compiler* comp, ASTNode* node) {
     switch (node->type) {
         case AST_BLOCK:
             for (int i = 0; i < node->block.count; i++) {
+                // Temporary statement mati di akhir statement
+                int top = comp->next_reg;
                 compile_stmt(comp, node->block.statements[i]);
+                comp->next_reg = top;
             }
             break;
             
@@ -360,8 +601,7 @@ static void compile_stmt(Compiler* comp, ASTNode* node) {
                 emit(comp, MAKE_ABC(OP_MOVE, local, val_reg, 0));
             } else {
                 // Global
-                int k = add_constant(comp, make_string(node->assign.name));
-                emit(comp, MAKE_ABx(OP_SETGLOBAL, val_reg, k));
+                emit(comp, MAKE_ABx(OP_SETGLOBAL, val_reg, vm_global_slot(comp->vm, node->assign.name)));
             }
             break;
         }
@@ -369,6 +609,40 @@ static void compile_stmt(Compiler* comp, ASTNode* node) {
         case AST_EXPR_STMT:
             compile_expr(comp, node);
             break;
+        
+        case AST_FUNCTION: {
+            // Definisi = nilai fungsi disimpan ke namanya saat dieksekusi
+            int idx = compile_function(comp, node);
+            int reg = alloc_reg(comp);
+            emit(comp, MAKE_ABx(OP_LOADK, reg, add_constant(comp, make_function(idx))));
+            int local = find_local(comp, node->function.name);
+            if (local >= 0) {
+                emit(comp, MAKE_ABC(OP_MOVE, local, reg, 0));
+            } else {
+                emit(comp, MAKE_ABx(OP_SETGLOBAL, reg, vm_global_slot(comp->vm, node->function.name)));
+            }
+            break;
+        }
+        
+        case AST_RETURN: {
+            int reg;
+            ASTNode* value = node->return_stmt.value;
+            // kembalikan f(..) di dalam fungsi: frame ini dipakai ulang,
+            // jadi rekursi ekor berjalan dengan stack tetap
+            if (value && value->type == AST_CALL && value->call.name != intern_cstr("cetak") &&
+                comp->fn != &comp->vm->functions[0]) {
+                compile_call(comp, value, OP_TAILCALL);
+                break;
+            }
+            if (value) {
+                reg = compile_expr(comp, node->return_stmt.value);
+            } else {
+                reg = alloc_reg(comp);
+                emit(comp, MAKE_ABC(OP_LOADNIL, reg, 0, 0));
+            }
+            emit(comp, MAKE_ABC(OP_RETURN, reg, 0, 0));
+            break;
+        }
             
         case AST_IF: {
             int cond_reg = compile_expr(comp, node->if_stmt.condition);
@@ -385,19 +659,15 @@ static void compile_stmt(Compiler* comp, ASTNode* node) {
                 
                 // Patch jmp_if_not
                 int else_start = comp->fn->code_size;
-                comp->fn->code[jmp_if_not] = MAKE_ABC(OP_JMP_IF_NOT, cond_reg, 
-                                                       (else_start - jmp_if_not) & 0xFFFF, 0);
+                patch_jump(comp, jmp_if_not, else_start);
                 
                 compile_stmt(comp, node->if_stmt.else_branch);
                 
                 // Patch jmp_else
-                int end_pos = comp->fn->code_size;
-                comp->fn->code[jmp_else] = MAKE_ABC(OP_JMP, 0, (end_pos - jmp_else) & 0xFFFF, 0);
+                patch_jump(comp, jmp_else, comp->fn->code_size);
             } else {
                 // Patch jmp_if_not
-                int end_pos = comp->fn->code_size;
-                comp->fn->code[jmp_if_not] = MAKE_ABC(OP_JMP_IF_NOT, cond_reg,
-                                                       (end_pos - jmp_if_not) & 0xFFFF, 0);
+                patch_jump(comp, jmp_if_not, comp->fn->code_size);
             }
             break;
         }
@@ -412,13 +682,12 @@ static void compile_stmt(Compiler* comp, ASTNode* node) {
             compile_stmt(comp, node->while_stmt.body);
             
             // Jump back
-            int back_jmp = -(comp->fn->code_size - loop_start + 1);
-            emit(comp, MAKE_ABC(OP_JMP, 0, back_jmp & 0xFFFF, 0));
+            int back_jmp = comp->fn->code_size;
+            emit(comp, MAKE_ABx(OP_JMP, 0, 0));
+            patch_jump(comp, back_jmp, loop_start);
             
             // Patch exit
-            int end_pos = comp->fn->code_size;
-            comp->fn->code[jmp_if_not] = MAKE_ABC(OP_JMP_IF_NOT, cond_reg,
-                                                   (end_pos - jmp_if_not) & 0xFFFF, 0);
+            patch_jump(comp, jmp_if_not, comp->fn->code_size);
             break;
         }
         
@@ -432,10 +701,9 @@ static void compile_stmt(Compiler* comp, ASTNode* node) {
 void vm_compile(VM* vm, ASTNode* ast) {
     // Create main function
     FunctionProto* main_fn = &vm->functions[0];
-    main_fn->name = strdup("__main__");
+    main_fn->name = intern_cstr("__main__");
     main_fn->num_params = 0;
     main_fn->num_locals = 0;
-    main_fn->max_stack = MAX_REGISTERS;
     vm->num_functions = 1;
     vm->current_func = 0;
     
@@ -443,6 +711,7 @@ void vm_compile(VM* vm, ASTNode* ast) {
         .vm = vm,
         .fn = main_fn,
         .next_reg = 0,
+        .max_reg = 0,
         .num_locals = 0
     };
     current_compiler = &comp;
@@ -451,19 +720,41 @@ void vm_compile(VM* vm, ASTNode* ast) {
     
     // Add halt
     emit(&comp, MAKE_ABC(OP_HALT, 0, 0, 0));
+    main_fn->max_stack = comp.max_reg;
     
     current_compiler = NULL;
 }
 
+int vm_add_function(VM* vm, const char* name) {
+    if (vm->num_functions >= MAX_FUNCTIONS) {
+        fprintf(stderr, "Error: Terlalu banyak fungsi (maks %d)\n", MAX_FUNCTIONS);
+        exit(1);
+    }
+    int idx = vm->num_functions++;
+    FunctionProto* fn = &vm->functions[idx];
+    memset(fn, 0, sizeof(*fn));
+    fn->name = name;
+    return idx;
+}
+
 // === EXECUTION ===
 
+// Dispatch: dengan GCC/Clang (labels-as-values) setiap handler melompat
+// langsung ke handler opcode berikutnya lewat tabel label (direct
+// threading): satu lompatan tak langsung per instruksi, tanpa cek batas
+// switch. -DNIRVANA_SWITCH_DISPATCH (atau compiler lain) memakai loop
+// switch biasa; kedua mode berbagi badan handler yang sama.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(NIRVANA_SWITCH_DISPATCH)
+#define VM_THREADED
+#endif
+
 static const char* op_names[] = {
     "LOADK", "LOADBOOL", "LOADNIL", "MOVE",
     "ADD", "SUB", "MUL", "DIV", "MOD", "POW", "NEG",
     "EQ", "LT", "LE", "NE",
     "AND", "OR", "NOT",
     "JMP", "JMP_IF", "JMP_IF_NOT",
-    "CALL", "RETURN",
+    "CALL", "RETURN", "TAILCALL",
     "GETGLOBAL", "SETGLOBAL",
     "NEWTABLE", "GETTABLE", "SETTABLE",
     "PRINT", "HALT"
@@ -476,83 +767,122 @@ void vm_run(VM* vm) {
     }
     
     FunctionProto* fn = &vm->functions[0];
-    vm->pc = 0;
+    // Kode selalu diakhiri OP_HALT/OP_RETURN (vm_compile), jadi tidak
+    // perlu cek pc < code_size. pc menunjuk instruksi SETELAH yang sedang
+    // jalan.
+    const Instruction* pc = fn->code;
+    Instruction inst;
     
-    #define R(i) (vm->registers[i])
-    #define K(i) (fn->constants[i])
+    vm->frame_count = 0;
+    ensure_stack(vm, fn->max_stack);
+    CallFrame* frame = push_frame(vm);
+    frame->func_idx = 0;
+    frame->base = 0;
+    frame->pc = pc;
+    // R0 frame aktif; dihitung ulang setiap kali stack bisa berpindah
+    Value* base = vm->stack;
+    Value* k = fn->constants;
     
-    while (vm->pc < fn->code_size) {
-        Instruction inst = fn->code[vm->pc];
-        OpCode op = GET_OP(inst);
-        int a = GET_A(inst);
-        int b = GET_B(inst);
-        int c = GET_C(inst);
-        int bx = GET_Bx(inst);
-        int sbx = GET_sBx(inst);
-        
-        switch (op) {
-            case OP_LOADK:
-                R(a) = K(bx);
-                break;
+    #define R(i) (base[i])
+    #define K(i) (k[i])
+    // Operand didekode di handler yang memakainya saja
+    #define A   GET_A(inst)
+    #define B   GET_B(inst)
+    #define C   GET_C(inst)
+    #define BX  GET_Bx(inst)
+    #define SBX GET_sBx(inst)
+    
+#ifdef VM_THREADED
+    static const void* dispatch[] = {
+        [OP_LOADK] = &&L_OP_LOADK, [OP_LOADBOOL] = &&L_OP_LOADBOOL,
+        [OP_LOADNIL] = &&L_OP_LOADNIL, [OP_MOVE] = &&L_OP_MOVE,
+        [OP_ADD] = &&L_OP_ADD, [OP_SUB] = &&L_OP_SUB, [OP_MUL] = &&L_OP_MUL,
+        [OP_DIV] = &&L_OP_DIV, [OP_MOD] = &&L_OP_MOD, [OP_POW] = &&L_OP_POW,
+        [OP_NEG] = &&L_OP_NEG,
+        [OP_EQ] = &&L_OP_EQ, [OP_LT] = &&L_OP_LT, [OP_LE] = &&L_OP_LE, [OP_NE] = &&L_OP_NE,
+        [OP_AND] = &&L_OP_AND, [OP_OR] = &&L_OP_OR, [OP_NOT] = &&L_OP_NOT,
+        [OP_JMP] = &&L_OP_JMP, [OP_JMP_IF] = &&L_OP_JMP_IF, [OP_JMP_IF_NOT] = &&L_OP_JMP_IF_NOT,
+        [OP_CALL] = &&L_OP_CALL, [OP_RETURN] = &&L_OP_RETURN, [OP_TAILCALL] = &&L_OP_TAILCALL,
+        [OP_GETGLOBAL] = &&L_OP_GETGLOBAL, [OP_SETGLOBAL] = &&L_OP_SETGLOBAL,
+        [OP_NEWTABLE] = &&L_unknown, [OP_GETTABLE] = &&L_unknown, [OP_SETTABLE] = &&L_unknown,
+        [OP_PRINT] = &&L_OP_PRINT, [OP_HALT] = &&L_OP_HALT
+    };
+    #define VM_CASE(op) L_##op:
+    #define VM_DEFAULT  L_unknown:
+    #define VM_NEXT()   do { inst = *pc++; goto *dispatch[GET_OP(inst)]; } while (0)
+    VM_NEXT();
+    {           // padanan for/switch di bawah: kurung tutupnya dipakai bersama
+        {
+#else
+    #define VM_CASE(op) case op:
+    #define VM_DEFAULT  default:
+    #define VM_NEXT()   continue
+    for (;;) {
+        inst = *pc++;
+        switch (GET_OP(inst)) {
+#endif
+            VM_CASE(OP_LOADK)
+                R(A) = K(BX);
+                VM_NEXT();
                 
-            case OP_LOADBOOL:
-                R(a) = make_bool(b);
-                break;
+            VM_CASE(OP_LOADBOOL)
+                R(A) = make_bool(B);
+                VM_NEXT();
                 
-            case OP_LOADNIL:
-                R(a) = make_nil();
-                break;
+            VM_CASE(OP_LOADNIL)
+                R(A) = make_nil();
+                VM_NEXT();
                 
-            case OP_MOVE:
-                R(a) = R(b);
-                break;
+            VM_CASE(OP_MOVE)
+                R(A) = R(B);
+                VM_NEXT();
                 
-            case OP_ADD: {
+            VM_CASE(OP_ADD) {
                 double left, right;
-                if (!to_number(&R(b), &left) || !to_number(&R(c), &right)) {
+                if (!to_number(&R(B), &left) || !to_number(&R(C), &right)) {
                     fprintf(stderr, "Error: Cannot add non-numeric values\n");
                     exit(1);
                 }
                 // Use integer if both are integers
-                if (R(b).type == VAL_INT && R(c).type == VAL_INT) {
-                    R(a) = make_int(R(b).i + R(c).i);
+                if (VAL_TYPE(R(B)) == VAL_INT && VAL_TYPE(R(C)) == VAL_INT) {
+                    R(A) = make_int(AS_INT(R(B)) + AS_INT(R(C)));
                 } else {
-                    R(a) = make_float(left + right);
+                    R(A) = make_float(left + right);
                 }
-                break;
+                VM_NEXT();
             }
             
-            case OP_SUB: {
+            VM_CASE(OP_SUB) {
                 double left, right;
-                if (!to_number(&R(b), &left) || !to_number(&R(c), &right)) {
+                if (!to_number(&R(B), &left) || !to_number(&R(C), &right)) {
                     fprintf(stderr, "Error: Cannot subtract non-numeric values\n");
                     exit(1);
                 }
-                if (R(b).type == VAL_INT && R(c).type == VAL_INT) {
-                    R(a) = make_int(R(b).i - R(c).i);
+                if (VAL_TYPE(R(B)) == VAL_INT && VAL_TYPE(R(C)) == VAL_INT) {
+                    R(A) = make_int(AS_INT(R(B)) - AS_INT(R(C)));
                 } else {
-                    R(a) = make_float(left - right);
+                    R(A) = make_float(left - right);
                 }
-                break;
+                VM_NEXT();
             }
             
-            case OP_MUL: {
+            VM_CASE(OP_MUL) {
                 double left, right;
-                if (!to_number(&R(b), &left) || !to_number(&R(c), &right)) {
+                if (!to_number(&R(B), &left) || !to_number(&R(C), &right)) {
                     fprintf(stderr, "Error: Cannot multiply non-numeric values\n");
                     exit(1);
                 }
-                if (R(b).type == VAL_INT && R(c).type == VAL_INT) {
-                    R(a) = make_int(R(b).i * R(c).i);
+                if (VAL_TYPE(R(B)) == VAL_INT && VAL_TYPE(R(C)) == VAL_INT) {
+                    R(A) = make_int(AS_INT(R(B)) * AS_INT(R(C)));
                 } else {
-                    R(a) = make_float(left * right);
+                    R(A) = make_float(left * right);
                 }
-                break;
+                VM_NEXT();
             }
             
-            case OP_DIV: {
+            VM_CASE(OP_DIV) {
                 double left, right;
-                if (!to_number(&R(b), &left) || !to_number(&R(c), &right)) {
+                if (!to_number(&R(B), &left) || !to_number(&R(C), &right)) {
                     fprintf(stderr, "Error: Cannot divide non-numeric values\n");
                     exit(1);
                 }
@@ -560,193 +890,257 @@ void vm_run(VM* vm) {
                     fprintf(stderr, "Error: Division by zero\n");
                     exit(1);
                 }
-                R(a) = make_float(left / right);
-                break;
+                R(A) = make_float(left / right);
+                VM_NEXT();
             }
             
-            case OP_MOD: {
-                if (R(b).type != VAL_INT || R(c).type != VAL_INT) {
+            VM_CASE(OP_MOD) {
+                if (VAL_TYPE(R(B)) != VAL_INT || VAL_TYPE(R(C)) != VAL_INT) {
                     fprintf(stderr, "Error: Modulo requires integers\n");
                     exit(1);
                 }
-                R(a) = make_int(R(b).i % R(c).i);
-                break;
+                R(A) = make_int(AS_INT(R(B)) % AS_INT(R(C)));
+                VM_NEXT();
             }
             
-            case OP_POW: {
+            VM_CASE(OP_POW) {
                 double left, right;
-                if (!to_number(&R(b), &left) || !to_number(&R(c), &right)) {
+                if (!to_number(&R(B), &left) || !to_number(&R(C), &right)) {
                     fprintf(stderr, "Error: Cannot power non-numeric values\n");
                     exit(1);
                 }
-                R(a) = make_float(pow(left, right));
-                break;
+                R(A) = make_float(pow(left, right));
+                VM_NEXT();
             }
             
-            case OP_NEG: {
+            VM_CASE(OP_NEG) {
                 double val;
-                if (!to_number(&R(b), &val)) {
+                if (!to_number(&R(B), &val)) {
                     fprintf(stderr, "Error: Cannot negate non-numeric value\n");
                     exit(1);
                 }
-                if (R(b).type == VAL_INT) {
-                    R(a) = make_int(-R(b).i);
+                if (VAL_TYPE(R(B)) == VAL_INT) {
+                    R(A) = make_int(-AS_INT(R(B)));
                 } else {
-                    R(a) = make_float(-val);
+                    R(A) = make_float(-val);
                 }
-                break;
+                VM_NEXT();
             }
             
-            case OP_EQ: {
+            VM_CASE(OP_EQ) {
                 int result = 0;
-                if (R(b).type != R(c).type) {
+                if (VAL_TYPE(R(B)) != VAL_TYPE(R(C))) {
                     result = 0;
                 } else {
-                    switch (R(b).type) {
+                    switch (VAL_TYPE(R(B))) {
                         case VAL_NIL: result = 1; break;
-                        case VAL_BOOL: result = R(b).i == R(c).i; break;
-                        case VAL_INT: result = R(b).i == R(c).i; break;
-                        case VAL_FLOAT: result = R(b).f == R(c).f; break;
-                        case VAL_STRING: result = strcmp(R(b).s, R(c).s) == 0; break;
+                        case VAL_BOOL: result = AS_BOOL(R(B)) == AS_BOOL(R(C)); break;
+                        case VAL_INT: result = AS_INT(R(B)) == AS_INT(R(C)); break;
+                        case VAL_FLOAT: result = AS_FLOAT(R(B)) == AS_FLOAT(R(C)); break;
+                        case VAL_STRING: result = strings_equal(AS_STRING(R(B)), AS_STRING(R(C))); break;
                         default: result = 0;
                     }
                 }
-                R(a) = make_bool(result);
-                break;
+                R(A) = make_bool(result);
+                VM_NEXT();
             }
             
-            case OP_LT: {
+            VM_CASE(OP_LT) {
                 double left, right;
-                if (!to_number(&R(b), &left) || !to_number(&R(c), &right)) {
+                if (!to_number(&R(B), &left) || !to_number(&R(C), &right)) {
                     fprintf(stderr, "Error: Cannot compare non-numeric values\n");
                     exit(1);
                 }
-                R(a) = make_bool(left < right);
-                break;
+                R(A) = make_bool(left < right);
+                VM_NEXT();
             }
             
-            case OP_LE: {
+            VM_CASE(OP_LE) {
                 double left, right;
-                if (!to_number(&R(b), &left) || !to_number(&R(c), &right)) {
+                if (!to_number(&R(B), &left) || !to_number(&R(C), &right)) {
                     fprintf(stderr, "Error: Cannot compare non-numeric values\n");
                     exit(1);
                 }
-                R(a) = make_bool(left <= right);
-                break;
+                R(A) = make_bool(left <= right);
+                VM_NEXT();
             }
             
-            case OP_NE: {
+            VM_CASE(OP_NE) {
                 int result = 0;
-                if (R(b).type != R(c).type) {
+                if (VAL_TYPE(R(B)) != VAL_TYPE(R(C))) {
                     result = 1;
                 } else {
-                    switch (R(b).type) {
+                    switch (VAL_TYPE(R(B))) {
                         case VAL_NIL: result = 0; break;
-                        case VAL_BOOL: result = R(b).i != R(c).i; break;
-                        case VAL_INT: result = R(b).i != R(c).i; break;
-                        case VAL_FLOAT: result = R(b).f != R(c).f; break;
-                        case VAL_STRING: result = strcmp(R(b).s, R(c).s) != 0; break;
+                        case VAL_BOOL: result = AS_BOOL(R(B)) != AS_BOOL(R(C)); break;
+                        case VAL_INT: result = AS_INT(R(B)) != AS_INT(R(C)); break;
+                        case VAL_FLOAT: result = AS_FLOAT(R(B)) != AS_FLOAT(R(C)); break;
+                        case VAL_STRING: result = !strings_equal(AS_STRING(R(B)), AS_STRING(R(C))); break;
                         default: result = 1;
                     }
                 }
-                R(a) = make_bool(result);
-                break;
+                R(A) = make_bool(result);
+                VM_NEXT();
             }
             
-            case OP_AND:
-                R(a) = make_bool(is_truthy(&R(b)) && is_truthy(&R(c)));
-                break;
+            VM_CASE(OP_AND)
+                R(A) = make_bool(is_truthy(&R(B)) && is_truthy(&R(C)));
+                VM_NEXT();
                 
-            case OP_OR:
-                R(a) = make_bool(is_truthy(&R(b)) || is_truthy(&R(c)));
-                break;
+            VM_CASE(OP_OR)
+                R(A) = make_bool(is_truthy(&R(B)) || is_truthy(&R(C)));
+                VM_NEXT();
                 
-            case OP_NOT:
-                R(a) = make_bool(!is_truthy(&R(b)));
-                break;
+            VM_CASE(OP_NOT)
+                R(A) = make_bool(!is_truthy(&R(B)));
+                VM_NEXT();
                 
-            case OP_JMP:
-                vm->pc += sbx;
-                break;
+            VM_CASE(OP_JMP)
+                pc += SBX;
+                VM_NEXT();
                 
-            case OP_JMP_IF:
-                if (is_truthy(&R(a))) {
-                    vm->pc += sbx;
+            VM_CASE(OP_JMP_IF)
+                if (is_truthy(&R(A))) {
+                    pc += SBX;
                 }
-                break;
+                VM_NEXT();
                 
-            case OP_JMP_IF_NOT:
-                if (!is_truthy(&R(a))) {
-                    vm->pc += sbx;
+            VM_CASE(OP_JMP_IF_NOT)
+                if (!is_truthy(&R(A))) {
+                    pc += SBX;
                 }
-                break;
+                VM_NEXT();
                 
-            case OP_GETGLOBAL: {
-                const char* name = K(bx).s;
-                int found = 0;
-                for (int i = 0; i < vm->num_globals; i++) {
-                    if (strcmp(vm->globals[i].name, name) == 0) {
-                        R(a) = vm->globals[i].value;
-                        found = 1;
-                        break;
-                    }
+            VM_CASE(OP_GETGLOBAL)
+                if (!vm->globals.defined[BX]) {
+                    fprintf(stderr, "Error: Undefined variable '%s'\n", vm->globals.names[BX]);
+                    exit(1);
+                }
+                R(A) = vm->globals.values[BX];
+                VM_NEXT();
+            
+            VM_CASE(OP_SETGLOBAL)
+                if (!vm->globals.defined[BX]) {
+                    vm->globals.defined[BX] = 1;
+                    vm->globals.order[vm->globals.num_defined++] = BX;
                 }
-                if (!found) {
-                    fprintf(stderr, "Error: Undefined variable '%s'\n", name);
+                vm->globals.values[BX] = R(A);
+                VM_NEXT();
+            
+            VM_CASE(OP_CALL) {
+                if (VAL_TYPE(R(A)) != VAL_FUNCTION) {
+                    fprintf(stderr, "Error: Mencoba memanggil nilai yang bukan fungsi\n");
                     exit(1);
                 }
-                break;
+                int idx = AS_FUNCTION(R(A));
+                FunctionProto* callee = &vm->functions[idx];
+                int argc = (int)B - 1;
+                if (argc != callee->num_params) {
+                    fprintf(stderr, "Error: Jumlah argumen salah untuk fungsi '%s'. Diharapkan %d, didapat %d\n",
+                            callee->name, callee->num_params, argc);
+                    exit(1);
+                }
+                // Argumen sudah di R(A+1).. = R0.. callee: cukup geser base
+                int new_base = (int)(base - vm->stack) + A + 1;
+                vm->frames[vm->frame_count - 1].pc = pc;
+                ensure_stack(vm, new_base + callee->max_stack);
+                frame = push_frame(vm);
+                frame->func_idx = idx;
+                frame->base = new_base;
+                base = vm->stack + new_base;
+                for (int i = callee->num_params; i < callee->num_locals; i++) R(i) = make_nil();
+                fn = callee;
+                k = fn->constants;
+                pc = fn->code;
+                VM_NEXT();
             }
             
-            case OP_SETGLOBAL: {
-                const char* name = K(bx).s;
-                int found = 0;
-                for (int i = 0; i < vm->num_globals; i++) {
-                    if (strcmp(vm->globals[i].name, name) == 0) {
-                        vm->globals[i].value = R(a);
-                        found = 1;
-                        break;
-                    }
+            VM_CASE(OP_TAILCALL) {
+                if (VAL_TYPE(R(A)) != VAL_FUNCTION) {
+                    fprintf(stderr, "Error: Mencoba memanggil nilai yang bukan fungsi\n");
+                    exit(1);
                 }
-                if (!found) {
-                    int idx = vm->num_globals++;
-                    vm->globals[idx].name = strdup(name);
-                    vm->globals[idx].value = R(a);
+                int idx = AS_FUNCTION(R(A));
+                FunctionProto* callee = &vm->functions[idx];
+                int argc = (int)B - 1;
+                if (argc != callee->num_params) {
+                    fprintf(stderr, "Error: Jumlah argumen salah untuk fungsi '%s'. Diharapkan %d, didapat %d\n",
+                            callee->name, callee->num_params, argc);
+                    exit(1);
                 }
-                break;
+                // Frame ini dipakai ulang: argumen digeser turun ke R0.. dan
+                // hasil callee nanti langsung kembali ke pemanggil frame ini
+                for (int i = 0; i < argc; i++) R(i) = R(A + 1 + i);
+                frame = &vm->frames[vm->frame_count - 1];
+                ensure_stack(vm, frame->base + callee->max_stack);
+                base = vm->stack + frame->base;
+                frame->func_idx = idx;
+                for (int i = callee->num_params; i < callee->num_locals; i++) R(i) = make_nil();
+                fn = callee;
+                k = fn->constants;
+                pc = fn->code;
+                VM_NEXT();
             }
             
-            case OP_PRINT:
-                print_value(&R(a));
+            VM_CASE(OP_RETURN) {
+                if (vm->frame_count == 1) {
+                    // kembalikan di program utama: berhenti seperti HALT
+                    vm->pc = (int)(pc - 1 - fn->code);
+                    vm->frame_count = 0;
+                    return;
+                }
+                // Hasil ke R(A) CALL pemanggil = slot tepat di bawah R0
+                base[-1] = R(A);
+                vm->frame_count--;
+                frame = &vm->frames[vm->frame_count - 1];
+                base = vm->stack + frame->base;
+                fn = &vm->functions[frame->func_idx];
+                k = fn->constants;
+                pc = frame->pc;
+                VM_NEXT();
+            }
+            
+            VM_CASE(OP_PRINT)
+                print_value(&R(A));
                 printf("\n");
-                break;
+                VM_NEXT();
                 
-            case OP_HALT:
+            VM_CASE(OP_HALT)
+                vm->pc = (int)(pc - 1 - fn->code);
+                vm->frame_count = 0;
                 return;
                 
-            default:
-                fprintf(stderr, "Error: Unknown opcode %d\n", op);
+            VM_DEFAULT
+                fprintf(stderr, "Error: Unknown opcode %d\n", GET_OP(inst));
                 exit(1);
         }
-        
-        vm->pc++;
     }
     
     #undef R
     #undef K
+    #undef A
+    #undef B
+    #undef C
+    #undef BX
+    #undef SBX
+    #undef VM_CASE
+    #undef VM_DEFAULT
+    #undef VM_NEXT
 }
 
 // === DEBUG ===
 
-void vm_print_bytecode(VM* vm) {
-    if (vm->num_functions == 0) return;
-    
-    FunctionProto* fn = &vm->functions[0];
-    printf("\n=== BYTECODE [%s] ===\n", fn->name);
+static void print_function(VM* vm, FunctionProto* fn) {
+    printf("\n=== BYTECODE [%s] (%d param, %d register) ===\n",
+           fn->name, fn->num_params, fn->max_stack);
     printf("Constants:\n");
     for (int i = 0; i < fn->num_constants; i++) {
         printf("  [%d] = ", i);
-        print_value(&fn->constants[i]);
+        if (VAL_TYPE(fn->constants[i]) == VAL_FUNCTION) {
+            printf("<fungsi %s>", vm->functions[AS_FUNCTION(fn->constants[i])].name);
+        } else {
+            print_value(&fn->constants[i]);
+        }
         printf("\n");
     }
     printf("\nInstructions:\n");
@@ -763,9 +1157,11 @@ void vm_print_bytecode(VM* vm) {
         
         switch (op) {
             case OP_LOADK:
+                printf("R%d, K%d", a, bx);
+                break;
             case OP_GETGLOBAL:
             case OP_SETGLOBAL:
-                printf("R%d, K%d", a, bx);
+                printf("R%d, %s", a, vm->globals.names[bx]);
                 break;
             case OP_LOADBOOL:
                 printf("R%d, %s", a, b ? "true" : "false");
@@ -773,8 +1169,13 @@ void vm_print_bytecode(VM* vm) {
             case OP_LOADNIL:
             case OP_PRINT:
             case OP_HALT:
+            case OP_RETURN:
                 printf("R%d", a);
                 break;
+            case OP_CALL:
+            case OP_TAILCALL:
+                printf("R%d, %d arg", a, b - 1);
+                break;
             case OP_MOVE:
                 printf("R%d, R%d", a, b);
                 break;
@@ -791,12 +1192,19 @@ void vm_print_bytecode(VM* vm) {
     }
 }
 
+void vm_print_bytecode(VM* vm) {
+    for (int i = 0; i < vm->num_functions; i++) {
+        print_function(vm, &vm->functions[i]);
+    }
+}
+
+// Register frame program utama (stack[0..])
 void vm_print_registers(VM* vm) {
     printf("\n=== REGISTERS ===\n");
-    for (int i = 0; i < 16; i++) {
-        if (vm->registers[i].type != VAL_NIL) {
+    for (int i = 0; i < 16 && i < vm->stack_size; i++) {
+        if (VAL_TYPE(vm->stack[i]) != VAL_NIL) {
             printf("R%d: ", i);
-            print_value(&vm->registers[i]);
+            print_value(&vm->stack[i]);
             printf("\n");
         }
     }
@@ -804,9 +1212,10 @@ void vm_print_registers(VM* vm) {
 
 void vm_print_globals(VM* vm) {
     printf("\n=== GLOBALS ===\n");
-    for (int i = 0; i < vm->num_globals; i++) {
-        printf("%s = ", vm->globals[i].name);
-        print_value(&vm->globals[i].value);
+    for (int i = 0; i < vm->globals.num_defined; i++) {
+        int slot = vm->globals.order[i];
+        printf("%s = ", vm->globals.names[slot]);
+        print_value(&vm->globals.values[slot]);
         printf("\n");
     }
 }
@@ -2,17 +2,26 @@
 #define VM_H
 
 #include "parser.h"
+#include <stddef.h>
 #include <stdint.h>
 
 // === REGISTER-BASED VM DESIGN ===
-// Inspired by LuaJIT: Uses 256 registers (R0-R255)
+// Inspired by LuaJIT: Uses 256 registers (R0-R255) per call frame
 // Instructions are 32-bit: [OP:8][A:8][B:8][C:8] or [OP:8][A:8][Bx:16]
+//
+// Register setiap frame adalah jendela di satu stack register yang
+// tumbuh: R0 frame = stack[base]. CALL A B memberi callee base baru
+// tepat setelah R(A), jadi argumen R(A+1).. langsung menjadi parameter
+// R0.. callee tanpa disalin, dan nilai kembali ditulis ke R(A) pemanggil.
 
 #define MAX_REGISTERS 256
 #define MAX_CONSTANTS 65536
 #define MAX_FUNCTIONS 256
 
 // Value types (tagged union for dynamic typing)
+// Representasi Value dipilih saat kompilasi: default struct tag+union
+// (16 byte); -DNIRVANA_NAN_BOXING memakai NaN-boxing (8 byte). Kode VM
+// hanya mengakses nilai lewat make_*() dan makro VAL_TYPE/AS_*.
 typedef enum {
     VAL_NIL,
     VAL_BOOL,
@@ -23,6 +32,37 @@ typedef enum {
     VAL_NATIVE
 } ValueType;
 
+#ifdef NIRVANA_NAN_BOXING
+// Value 8 byte (NaN-boxing): float disimpan apa adanya sebagai bit double,
+// tipe lain dikodekan di ruang quiet-NaN bertanda negatif:
+//   [1111111111111][tag:3][payload:48]   dengan tag = ValueType + 1
+// NaN hasil aritmetika dinormalkan ke NaN positif oleh make_float, jadi
+// tidak pernah bertabrakan dengan nilai ber-tag. Int dibatasi 48 bit
+// (bertanda) dan pointer string memakai 48 bit alamat bawah.
+typedef uint64_t Value;
+
+#define NB_BOX_MASK     0xFFF8000000000000ULL
+#define NB_PAYLOAD_MASK 0x0000FFFFFFFFFFFFULL
+#define NB_INT_MIN      (-((int64_t)1 << 47))
+#define NB_INT_MAX      (((int64_t)1 << 47) - 1)
+
+#define NB_IS_BOXED(v)  (((v) & NB_BOX_MASK) == NB_BOX_MASK)
+#define NB_BOX(t, p)    (NB_BOX_MASK | ((uint64_t)((t) + 1) << 48) | \
+                         ((uint64_t)(p) & NB_PAYLOAD_MASK))
+
+#define VAL_TYPE(v)     (NB_IS_BOXED(v) ? (ValueType)((((v) >> 48) & 7) - 1) \
+                                        : VAL_FLOAT)
+#define AS_INT(v)       ((int64_t)((v) << 16) >> 16)
+#define AS_BOOL(v)      ((int)((v) & 1))
+#define AS_FLOAT(v)     nb_as_float(v)
+#define AS_STRING(v)    ((char*)(uintptr_t)((v) & NB_PAYLOAD_MASK))
+#define AS_FUNCTION(v)  ((int)((v) & NB_PAYLOAD_MASK))
+
+static inline double nb_as_float(Value v) {
+    union { uint64_t bits; double f; } u = { v };
+    return u.f;
+}
+#else
 typedef struct {
     ValueType type;
     union {
@@ -39,6 +79,34 @@ typedef struct {
     };
 } Value;
 
+#define VAL_TYPE(v)     ((v).type)
+#define AS_INT(v)       ((v).i)
+#define AS_BOOL(v)      ((int)(v).i)
+#define AS_FLOAT(v)     ((v).f)
+#define AS_STRING(v)    ((v).s)
+#define AS_FUNCTION(v)  ((v).func.idx)
+#endif
+
+// Header objek heap yang dikelola GC (gc.c), saat ini hanya string.
+typedef struct GCObject {
+    struct GCObject* next;
+    uint8_t type;           // VAL_STRING
+    uint8_t marked;
+} GCObject;
+
+// Header string terletak tepat sebelum karakter, jadi AS_STRING tetap
+// char* biasa (juga di payload NaN-boxing) dan STRING_OBJ mundur ke
+// header. String tidak bisa diubah: panjang dan hash FNV-1a dihitung
+// sekali saat dibuat, jadi EQ/NE menolak lewat panjang/hash sebelum
+// membandingkan byte dan GC tidak perlu strlen untuk ukuran objek.
+typedef struct {
+    GCObject gc;
+    uint32_t length;
+    uint32_t hash;
+} StringObj;
+
+#define STRING_OBJ(s) ((StringObj*)(s) - 1)
+
 // Instruction format
 typedef enum {
     // Load/Store
@@ -74,11 +142,12 @@ typedef enum {
     
     // Function call
     OP_CALL,        // R(A) = call(R(A), args=R(A+1)..R(A+B-1))
-    OP_RETURN,      // return R(A)
+    OP_RETURN,      // return R(A) ke R(A) CALL pemanggil
+    OP_TAILCALL,    // return R(A)(R(A+1)..R(A+B-1)), memakai ulang frame ini
     
     // Variables (global)
-    OP_GETGLOBAL,   // R(A) = G[K(Bx)]
-    OP_SETGLOBAL,   // G[K(Bx)] = R(A)
+    OP_GETGLOBAL,   // R(A) = G[Bx]   (Bx = slot global, lihat GlobalTable)
+    OP_SETGLOBAL,   // G[Bx] = R(A)
     
     // Table operations (for arrays/dicts)
     OP_NEWTABLE,    // R(A) = new table
@@ -105,10 +174,10 @@ typedef uint32_t Instruction;
 
 // Function prototype
 typedef struct {
-    char* name;
+    const char* name;       // simbol intern
     int num_params;
-    int num_locals;
-    int max_stack;
+    int num_locals;         // parameter + lokal, R0..num_locals-1
+    int max_stack;          // register frame yang dipakai
     Instruction* code;
     int code_size;
     int code_capacity;
@@ -116,6 +185,43 @@ typedef struct {
     int num_constants;
 } FunctionProto;
 
+// Variabel global: setiap nama (simbol intern) mendapat slot padat saat
+// kompilasi, jadi GETGLOBAL/SETGLOBAL cukup mengindeks values[Bx] tanpa
+// mencari nama. Indeks hash nama -> slot hanya dipakai saat kompilasi
+// dan untuk nama yang dibuat lewat API (vm_global_slot), dan tumbuh
+// tanpa batas tetap selain 16 bit Bx.
+typedef struct {
+    const char** names;     // slot -> simbol intern
+    Value* values;
+    unsigned char* defined; // 0 sampai SETGLOBAL pertama ke slot itu
+    int count;
+    int capacity;
+    int* index;             // open addressing: simbol -> slot, -1 = kosong
+    int index_capacity;     // pangkat dua, terisi maksimal setengah
+    int* order;             // slot dalam urutan definisi (vm_print_globals)
+    int num_defined;
+} GlobalTable;
+
+// Frame aktif; frame 0 adalah program utama (functions[0])
+typedef struct {
+    int func_idx;
+    int base;                   // indeks R0 frame ini di stack register
+    const Instruction* pc;      // titik lanjut selama frame ini memanggil
+} CallFrame;
+
+// Heap GC: koleksi dipicu alokasi begitu `bytes` melewati `next_gc`,
+// lalu ambang diset ke GC_HEAP_GROW x heap yang masih hidup.
+typedef struct {
+    GCObject* objects;
+    size_t bytes;           // header + payload semua objek
+    size_t next_gc;
+    // Statistik (dicetak dengan -DNIRVANA_GC_STATS)
+    int collections;
+    size_t objects_allocated, objects_freed;
+    size_t bytes_freed, peak_bytes;
+    double pause_total_ms, pause_max_ms;
+} Heap;
+
 // VM State
 typedef struct {
     // Code
@@ -123,28 +229,21 @@ typedef struct {
     int num_functions;
     int current_func;
     
-    // Registers (like LuaJIT)
-    Value registers[MAX_REGISTERS];
+    // Registers (like LuaJIT): jendela per frame di stack yang tumbuh
+    Value* stack;
+    int stack_size;
     int pc;                     // Program counter
     
     // Global variables
-    struct {
-        char* name;
-        Value value;
-    } globals[256];
-    int num_globals;
+    GlobalTable globals;
     
-    // Call stack
-    struct {
-        int func_idx;
-        int pc;
-        int base;
-    } call_stack[64];
-    int call_depth;
+    // Call stack (tumbuh, tanpa batas kedalaman tetap)
+    CallFrame* frames;
+    int frame_count;
+    int frame_capacity;
     
     // Memory management
-    char* string_pool[1024];    // For GC
-    int string_count;
+    Heap heap;
 } VM;
 
 // API
@@ -155,6 +254,8 @@ void vm_destroy(VM* vm);
 void vm_compile(VM* vm, ASTNode* ast);
 int vm_add_constant(VM* vm, Value val);
 int vm_add_function(VM* vm, const char* name);
+// Slot global untuk simbol intern `name`; dibuat bila belum ada.
+int vm_global_slot(VM* vm, const char* name);
 
 // Execution
 void vm_run(VM* vm);
@@ -0,0 +1,72 @@
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGN 8
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static ArenaBlock* block_new(size_t size) {
+    ArenaBlock* b = malloc(sizeof(ArenaBlock) + size);
+    if (!b) {
+        fprintf(stderr, "Error: Alokasi memori gagal untuk arena\n");
+        exit(1);
+    }
+    b->next = NULL;
+    b->used = 0;
+    b->size = size;
+    return b;
+}
+
+void arena_init(Arena* arena) {
+    arena->head = NULL;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    size = align_up(size);
+    ArenaBlock* b = arena->head;
+    if (!b || b->used + size > b->size) {
+        // Alokasi besar mendapat blok sendiri seukurannya.
+        b = block_new(size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE);
+        b->next = arena->head;
+        arena->head = b;
+    }
+    void* p = b->data + b->used;
+    b->used += size;
+    return p;
+}
+
+void* arena_grow(Arena* arena, void* ptr, size_t old_size, size_t new_size) {
+    if (!ptr) return arena_alloc(arena, new_size);
+    ArenaBlock* b = arena->head;
+    old_size = align_up(old_size);
+    if ((char*)ptr + old_size == b->data + b->used &&
+        b->used - old_size + align_up(new_size) <= b->size) {
+        b->used = b->used - old_size + align_up(new_size);
+        return ptr;
+    }
+    void* p = arena_alloc(arena, new_size);
+    memcpy(p, ptr, old_size < new_size ? old_size : new_size);
+    return p;
+}
+
+char* arena_strndup(Arena* arena, const char* s, size_t len) {
+    char* d = arena_alloc(arena, len + 1);
+    memcpy(d, s, len);
+    d[len] = '\0';
+    return d;
+}
+
+void arena_free(Arena* arena) {
+    ArenaBlock* b = arena->head;
+    while (b) {
+        ArenaBlock* next = b->next;
+        free(b);
+        b = next;
+    }
+    arena->head = NULL;
+}
@@ -0,0 +1,28 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Arena kompilasi: satu arena memiliki semua string literal dan node AST
+// dari satu file sumber. Alokasi cukup menggeser pointer di blok aktif,
+// dan seluruh isinya dilepas sekaligus dengan arena_free().
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock* head;   // blok aktif; blok lama dirantai lewat next
+} Arena;
+
+void arena_init(Arena* arena);
+void* arena_alloc(Arena* arena, size_t size);
+// Perbesar alokasi terakhir di tempat bila muat; selain itu salin ke
+// alokasi baru (memori lama tetap milik arena sampai arena_free).
+void* arena_grow(Arena* arena, void* ptr, size_t old_size, size_t new_size);
+char* arena_strndup(Arena* arena, const char* s, size_t len);
+void arena_free(Arena* arena);
+
+#endif // ARENA_H
@@ -0,0 +1,74 @@
+// Benchmark throughput lexer (MB/s) atas sumber besar yang dibangkitkan.
+// Token ditarik satu per satu lewat lexer_next() tanpa disimpan.
+//
+// Build dari direktori V0.4 (tambahkan -mavx2 untuk jalur AVX2,
+// -mno-sse2 untuk jalur skalar):
+//   gcc -O2 -I. -o /tmp/bench_lexer bench/bench_lexer.c lexer.c trace.c
+// Jalankan:
+//   /tmp/bench_lexer [ukuran_MB] [ulangan]
+#define _POSIX_C_SOURCE 200809L
+#include "../lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Campuran yang mewakili skrip nyata: identifier panjang dan pendek,
+// keyword, komentar, string, angka, dan indentasi.
+static const char* snippet =
+    "# hitung jumlah kuadrat dari elemen yang memenuhi syarat\n"
+    "fungsi jumlah_kuadrat_terfilter(daftar_angka, batas_bawah) {\n"
+    "    total_sementara = 0\n"
+    "    untuk elemen dalam daftar_angka:\n"
+    "        jika (elemen >= batas_bawah && elemen != 13) {\n"
+    "            total_sementara = total_sementara + elemen * elemen\n"
+    "        }\n"
+    "    kembali total_sementara\n"
+    "}\n"
+    "pesan = \"hasil perhitungan untuk data percobaan nomor satu\"\n"
+    "nilai_awal = [1, 2, 3.5, 42, 1000]   # daftar uji\n"
+    "cetak(pesan, jumlah_kuadrat_terfilter(nilai_awal, 2))\n"
+    "\n";
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    int megabytes = argc > 1 ? atoi(argv[1]) : 32;
+    int rounds = argc > 2 ? atoi(argv[2]) : 3;
+
+    size_t snippet_len = strlen(snippet);
+    size_t target = (size_t)megabytes * 1024 * 1024;
+    size_t copies = target / snippet_len + 1;
+    size_t size = copies * snippet_len;
+    char* source = malloc(size + 1);
+    if (!source) {
+        fprintf(stderr, "Error: Alokasi memori gagal untuk sumber\n");
+        return 1;
+    }
+    for (size_t i = 0; i < copies; i++) memcpy(source + i * snippet_len, snippet, snippet_len);
+    source[size] = '\0';
+
+    double best = 0;
+    int tokens = 0;
+    for (int r = 0; r < rounds; r++) {
+        double start = now_seconds();
+        Lexer lexer;
+        lexer_init(&lexer, source, size);
+        tokens = 0;
+        while (lexer_next(&lexer).type != TOKEN_EOF) tokens++;
+        tokens++;
+        double elapsed = now_seconds() - start;
+        double mbps = size / (1024.0 * 1024.0) / elapsed;
+        printf("putaran %d: %.3f s, %.1f MB/s\n", r + 1, elapsed, mbps);
+        if (mbps > best) best = mbps;
+    }
+    printf("%.1f MB sumber, %d token, terbaik %.1f MB/s\n",
+           size / (1024.0 * 1024.0), tokens, best);
+
+    free(source);
+    return 0;
+}
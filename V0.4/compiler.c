@@ -0,0 +1,516 @@
+#include "compiler.h"
+#include "intern.h"
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Error kompilasi: pesan ditulis ke `error` lalu longjmp kembali ke
+// compile_program(), seperti error parse. Dibagi semua FuncState.
+typedef struct {
+    jmp_buf on_error;
+    char* error;
+    Proto* program;     // dilepas setelah longjmp (di memori, bukan register)
+} CompileErr;
+
+typedef struct FuncState {
+    struct FuncState* parent;
+    CompileErr* err;
+    Proto* p;
+    int level;      // kedalaman fungsi; 0 = top-level
+    int free_reg;   // register bebas pertama (temp dimulai di sini)
+    int line;       // baris node yang sedang dikompilasi
+    // Lokal register yang pasti sudah diisi di titik kompilasi ini.
+    // Pembacaan lokal lain didahului OP_CHECKREG supaya error "Undefined
+    // variable" sama dengan eval(); cabang jika/loop tidak menambahkan.
+    unsigned char assigned[MAX_REGS];
+} FuncState;
+
+typedef enum { NAME_REG, NAME_ENV, NAME_GLOBAL } NameKind;
+
+static void compile_error(FuncState* fs, const char* msg) {
+    snprintf(fs->err->error, COMPILE_ERROR_SIZE, "Compile Error [baris %d]: %s\n", fs->line, msg);
+    longjmp(fs->err->on_error, 1);
+}
+
+static Proto* proto_new(const char* name) {
+    Proto* p = calloc(1, sizeof(Proto));
+    p->name = intern_cstr(name);
+    return p;
+}
+
+static int emit(FuncState* fs, Instruction inst) {
+    Proto* p = fs->p;
+    if (p->code_size >= p->code_capacity) {
+        p->code_capacity = p->code_capacity ? p->code_capacity * 2 : 64;
+        p->code = realloc(p->code, sizeof(Instruction) * p->code_capacity);
+        p->lines = realloc(p->lines, sizeof(int) * p->code_capacity);
+        p->names = realloc(p->names, sizeof(const char*) * p->code_capacity);
+    }
+    p->code[p->code_size] = inst;
+    p->lines[p->code_size] = fs->line;
+    p->names[p->code_size] = NULL;
+    return p->code_size++;
+}
+
+// Offset lompatan relatif ke instruksi sesudah instruksi lompatan.
+static void patch_jump(FuncState* fs, int at, int target) {
+    int offset = target - (at + 1);
+    if (offset < INT16_MIN || offset > INT16_MAX) {
+        compile_error(fs, "Lompatan terlalu jauh");
+    }
+    Instruction i = fs->p->code[at];
+    fs->p->code[at] = MAKE_ABx(GET_OP(i), GET_A(i), (uint16_t)offset);
+}
+
+static int alloc_reg(FuncState* fs) {
+    if (fs->free_reg >= MAX_REGS) {
+        compile_error(fs, "Kehabisan register (ekspresi terlalu kompleks)");
+    }
+    int r = fs->free_reg++;
+    if (fs->free_reg > fs->p->max_regs) fs->p->max_regs = fs->free_reg;
+    return r;
+}
+
+// Konstanta kembar dipakai ulang; string dibandingkan isinya.
+static int add_constant(FuncState* fs, Value v) {
+    Proto* p = fs->p;
+    for (int i = 0; i < p->num_constants; i++) {
+        Value k = p->constants[i];
+        if (k.type != v.type) continue;
+        if (v.type == VAL_NUMBER && k.number == v.number) return i;
+        if (v.type == VAL_FLOAT && k.float_num == v.float_num) return i;
+        if (v.type == VAL_STRING && strcmp(k.string->chars, v.string->chars) == 0) {
+            value_free(v);
+            return i;
+        }
+    }
+    if (p->num_constants >= MAX_CONSTANTS) {
+        value_free(v);
+        compile_error(fs, "Terlalu banyak konstanta");
+    }
+    p->constants = realloc(p->constants, sizeof(Value) * (p->num_constants + 1));
+    p->constants[p->num_constants] = v;
+    return p->num_constants++;
+}
+
+// -------------------------------------------------------------------
+// Akses nama
+// -------------------------------------------------------------------
+// depth == level berarti nama hidup di scope global. depth 0 pada fungsi
+// tanpa own_env berarti register lokal. Sisanya lewat rantai Environment:
+// frame own_env adalah env sendiri (hop 0), frame register langsung
+// memakai env closure sehingga hop-nya berkurang satu.
+static NameKind name_kind(FuncState* fs, ASTNode* n) {
+    if (n->depth == fs->level) return NAME_GLOBAL;
+    if (n->depth == 0 && !fs->p->own_env) return NAME_REG;
+    return NAME_ENV;
+}
+
+static Instruction env_access(FuncState* fs, OpCode op, int reg, ASTNode* n) {
+    int hops = n->depth - (fs->p->own_env ? 0 : 1);
+    if (hops > 255 || n->slot > 255) compile_error(fs, "Akses variabel terlalu dalam");
+    return MAKE_ABC(op, reg, hops, n->slot);
+}
+
+static Instruction global_access(FuncState* fs, OpCode op, int reg, ASTNode* n) {
+    if (n->slot > 0xFFFF) compile_error(fs, "Terlalu banyak variabel global");
+    return MAKE_ABx(op, reg, n->slot);
+}
+
+static void check_reg(FuncState* fs, ASTNode* n) {
+    if (fs->assigned[n->slot]) return;
+    emit(fs, MAKE_ABx(OP_CHECKREG, n->slot, add_constant(fs, value_string(n->name))));
+    fs->assigned[n->slot] = 1;
+}
+
+static void load_name(FuncState* fs, ASTNode* n, int dst) {
+    switch (name_kind(fs, n)) {
+        case NAME_REG:
+            check_reg(fs, n);
+            if (dst != n->slot) emit(fs, MAKE_ABC(OP_MOVE, dst, n->slot, 0));
+            break;
+        case NAME_ENV: {
+            int at = emit(fs, env_access(fs, OP_GETENV, dst, n));
+            fs->p->names[at] = n->name;   // pesan "Undefined variable"
+            break;
+        }
+        case NAME_GLOBAL: emit(fs, global_access(fs, OP_GETGLOBAL, dst, n)); break;
+    }
+}
+
+static void store_name(FuncState* fs, ASTNode* n, int src) {
+    switch (name_kind(fs, n)) {
+        case NAME_REG:
+            if (src != n->slot) emit(fs, MAKE_ABC(OP_MOVE, n->slot, src, 0));
+            fs->assigned[n->slot] = 1;
+            break;
+        case NAME_ENV: emit(fs, env_access(fs, OP_SETENV, src, n)); break;
+        case NAME_GLOBAL: emit(fs, global_access(fs, OP_SETGLOBAL, src, n)); break;
+    }
+}
+
+// -------------------------------------------------------------------
+// Ekspresi
+// -------------------------------------------------------------------
+static void expr_to(FuncState* fs, ASTNode* n, int dst);
+static void compile_stmt(FuncState* fs, ASTNode* n);
+static int compile_function(FuncState* fs, ASTNode* fn);
+
+// Hasil ekspresi di register mana pun: lokal register dipakai langsung
+// tanpa MOVE, selain itu dievaluasi ke temp baru.
+static int expr_any(FuncState* fs, ASTNode* n) {
+    if (n->type == AST_IDENTIFIER && name_kind(fs, n) == NAME_REG) {
+        check_reg(fs, n);
+        return n->slot;
+    }
+    int r = alloc_reg(fs);
+    expr_to(fs, n, r);
+    return r;
+}
+
+// -1 untuk operator yang di eval() juga menghasilkan kosong (mis. pangkat).
+static int binary_opcode(TokenType op) {
+    switch (op) {
+        case TOKEN_PLUS: return OP_ADD;
+        case TOKEN_MINUS: return OP_SUB;
+        case TOKEN_BINTANG: return OP_MUL;
+        case TOKEN_GARING: return OP_DIV;
+        case TOKEN_PERSEN: return OP_MOD;
+        case TOKEN_EQ: return OP_EQ;
+        case TOKEN_NEQ: return OP_NE;
+        case TOKEN_LT: return OP_LT;
+        case TOKEN_LTE: return OP_LE;
+        case TOKEN_GT: return OP_GT;
+        case TOKEN_GTE: return OP_GE;
+        case TOKEN_AND: return OP_AND;
+        case TOKEN_OR: return OP_OR;
+        default: return -1;
+    }
+}
+
+// Argumen di R(base+1).., fungsi di R(base); hasil CALL tertulis ke R(base).
+// `op` adalah OP_CALL atau OP_TAILCALL (yang tidak kembali ke frame ini).
+static void compile_call(FuncState* fs, ASTNode* n, int dst, OpCode op) {
+    int argc = n->call.arg_count;
+    if (argc > 255) compile_error(fs, "Terlalu banyak argumen");
+    int base = alloc_reg(fs);
+    load_name(fs, n, base);
+    for (int i = 0; i < argc; i++) alloc_reg(fs);
+    for (int i = 0; i < argc; i++) expr_to(fs, n->call.args[i], base + 1 + i);
+    emit(fs, MAKE_ABC(op, base, argc, 0));
+    if (op == OP_CALL && dst != base) emit(fs, MAKE_ABC(OP_MOVE, dst, base, 0));
+}
+
+static void expr_to(FuncState* fs, ASTNode* n, int dst) {
+    int saved_reg = fs->free_reg;
+    int saved_line = fs->line;
+    fs->line = n->line;
+    switch (n->type) {
+        case AST_NUMBER:
+            emit(fs, MAKE_ABx(OP_LOADK, dst, add_constant(fs, value_number(n->number))));
+            break;
+        case AST_FLOAT:
+            emit(fs, MAKE_ABx(OP_LOADK, dst, add_constant(fs, value_float(n->float_num))));
+            break;
+        case AST_STRING:
+            emit(fs, MAKE_ABx(OP_LOADK, dst, add_constant(fs, value_string(n->string))));
+            break;
+        case AST_BOOLEAN: emit(fs, MAKE_ABC(OP_LOADBOOL, dst, n->boolean ? 1 : 0, 0)); break;
+        case AST_NULL: emit(fs, MAKE_ABC(OP_LOADNIL, dst, 0, 0)); break;
+        case AST_ARRAY: {
+            // `a = [a]`: jangan timpa lokal sebelum elemennya dibaca.
+            int arr = dst < saved_reg && n->array.count > 0 ? alloc_reg(fs) : dst;
+            emit(fs, MAKE_ABC(OP_NEWARRAY, arr, 0, 0));
+            for (int i = 0; i < n->array.count; i++) {
+                int mark = fs->free_reg;
+                int r = expr_any(fs, n->array.elements[i]);
+                emit(fs, MAKE_ABC(OP_APPEND, arr, r, 0));
+                fs->free_reg = mark;
+            }
+            if (arr != dst) emit(fs, MAKE_ABC(OP_MOVE, dst, arr, 0));
+            break;
+        }
+        case AST_IDENTIFIER: load_name(fs, n, dst); break;
+        case AST_BINARY: {
+            int l = expr_any(fs, n->binary.left);
+            int r = expr_any(fs, n->binary.right);
+            int op = binary_opcode(n->binary.op);
+            if (op < 0) emit(fs, MAKE_ABC(OP_LOADNIL, dst, 0, 0));
+            else emit(fs, MAKE_ABC(op, dst, l, r));
+            break;
+        }
+        case AST_UNARY: {
+            int o = expr_any(fs, n->unary.operand);
+            if (n->unary.op == TOKEN_MINUS) emit(fs, MAKE_ABC(OP_NEG, dst, o, 0));
+            else if (n->unary.op == TOKEN_NOT) emit(fs, MAKE_ABC(OP_NOT, dst, o, 0));
+            else emit(fs, MAKE_ABC(OP_LOADNIL, dst, 0, 0));
+            break;
+        }
+        case AST_CALL: compile_call(fs, n, dst, OP_CALL); break;
+        case AST_INDEX: {
+            int obj = expr_any(fs, n->index.object);
+            int idx = expr_any(fs, n->index.index);
+            emit(fs, MAKE_ABC(OP_GETINDEX, dst, obj, idx));
+            break;
+        }
+        default:
+            compile_error(fs, "Ekspresi tidak didukung");
+    }
+    fs->free_reg = saved_reg;
+    fs->line = saved_line;
+}
+
+// -------------------------------------------------------------------
+// Statement
+// -------------------------------------------------------------------
+static void compile_assign(FuncState* fs, ASTNode* n) {
+    if (name_kind(fs, n) == NAME_REG) {
+        expr_to(fs, n->assign.value, n->slot);
+        fs->assigned[n->slot] = 1;
+    } else {
+        int r = expr_any(fs, n->assign.value);
+        store_name(fs, n, r);
+    }
+}
+
+static void compile_stmt(FuncState* fs, ASTNode* n) {
+    if (!n) return;
+    int saved_reg = fs->free_reg;
+    int saved_line = fs->line;
+    unsigned char before[MAX_REGS];     // fs->assigned sebelum cabang/loop
+    fs->line = n->line;
+    switch (n->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < n->block.count; i++) compile_stmt(fs, n->block.statements[i]);
+            break;
+        case AST_EXPR_STMT: expr_any(fs, n->expr_stmt.expr); break;
+        case AST_ASSIGN: compile_assign(fs, n); break;
+        case AST_IF: {
+            int cond = expr_any(fs, n->if_stmt.condition);
+            int jfalse = emit(fs, MAKE_ABx(OP_JMP_IF_NOT, cond, 0));
+            fs->free_reg = saved_reg;
+            memcpy(before, fs->assigned, sizeof(before));
+            compile_stmt(fs, n->if_stmt.then_branch);
+            if (n->if_stmt.else_branch) {
+                int jend = emit(fs, MAKE_ABx(OP_JMP, 0, 0));
+                patch_jump(fs, jfalse, fs->p->code_size);
+                // Pasti terisi sesudah jika = terisi di kedua cabang
+                unsigned char then_assigned[MAX_REGS];
+                memcpy(then_assigned, fs->assigned, sizeof(then_assigned));
+                memcpy(fs->assigned, before, sizeof(before));
+                compile_stmt(fs, n->if_stmt.else_branch);
+                for (int i = 0; i < MAX_REGS; i++) fs->assigned[i] &= then_assigned[i];
+                patch_jump(fs, jend, fs->p->code_size);
+            } else {
+                patch_jump(fs, jfalse, fs->p->code_size);
+                memcpy(fs->assigned, before, sizeof(before));
+            }
+            break;
+        }
+        case AST_WHILE: {
+            int start = fs->p->code_size;
+            int cond = expr_any(fs, n->while_stmt.condition);
+            int jexit = emit(fs, MAKE_ABx(OP_JMP_IF_NOT, cond, 0));
+            fs->free_reg = saved_reg;
+            memcpy(before, fs->assigned, sizeof(before));
+            compile_stmt(fs, n->while_stmt.body);
+            memcpy(fs->assigned, before, sizeof(before));   // badan bisa tidak jalan
+            int jback = emit(fs, MAKE_ABx(OP_JMP, 0, 0));
+            patch_jump(fs, jback, start);
+            patch_jump(fs, jexit, fs->p->code_size);
+            break;
+        }
+        case AST_FOR: {
+            int base = alloc_reg(fs);
+            alloc_reg(fs);  // indeks
+            alloc_reg(fs);  // panjang
+            alloc_reg(fs);  // elemen
+            expr_to(fs, n->for_stmt.iterable, base);
+            int jprep = emit(fs, MAKE_ABx(OP_FORPREP, base, 0));
+            int body = fs->p->code_size;
+            memcpy(before, fs->assigned, sizeof(before));
+            store_name(fs, n, base + 3);
+            compile_stmt(fs, n->for_stmt.body);
+            memcpy(fs->assigned, before, sizeof(before));
+            int jloop = emit(fs, MAKE_ABx(OP_FORLOOP, base, 0));
+            patch_jump(fs, jloop, body);
+            patch_jump(fs, jprep, jloop);
+            break;
+        }
+        case AST_FUNCTION: {
+            int r = alloc_reg(fs);
+            emit(fs, MAKE_ABx(OP_CLOSURE, r, compile_function(fs, n)));
+            store_name(fs, n, r);
+            break;
+        }
+        case AST_RETURN:
+            // `kembali f(...)` memakai ulang frame pemanggil. Frame own_env
+            // dikecualikan: env-nya bisa menjadi closure fungsi yang dipanggil.
+            if (n->return_stmt.value && n->return_stmt.value->type == AST_CALL &&
+                fs->parent && !fs->p->own_env) {
+                compile_call(fs, n->return_stmt.value, fs->free_reg, OP_TAILCALL);
+            } else if (n->return_stmt.value) {
+                emit(fs, MAKE_ABC(OP_RETURN, expr_any(fs, n->return_stmt.value), 1, 0));
+            } else {
+                emit(fs, MAKE_ABC(OP_RETURN, 0, 0, 0));
+            }
+            break;
+        default:
+            expr_any(fs, n);
+    }
+    fs->free_reg = saved_reg;
+    fs->line = saved_line;
+}
+
+// Statement `n` dengan nilainya ditulis ke R(dst), mengikuti nilai yang
+// dikembalikan eval(): blok = statement terakhir, jika = cabang yang
+// berjalan, loop = badan iterasi terakhir, selain itu kosong. R(dst) harus
+// temp di bawah free_reg supaya tidak tertimpa badan loop.
+static void stmt_value(FuncState* fs, ASTNode* n, int dst) {
+    if (!n) {
+        emit(fs, MAKE_ABC(OP_LOADNIL, dst, 0, 0));
+        return;
+    }
+    int saved_reg = fs->free_reg;
+    int saved_line = fs->line;
+    unsigned char before[MAX_REGS];
+    fs->line = n->line;
+    switch (n->type) {
+        case AST_BLOCK:
+            if (n->block.count == 0) {
+                emit(fs, MAKE_ABC(OP_LOADNIL, dst, 0, 0));
+                break;
+            }
+            for (int i = 0; i < n->block.count - 1; i++) compile_stmt(fs, n->block.statements[i]);
+            stmt_value(fs, n->block.statements[n->block.count - 1], dst);
+            break;
+        case AST_EXPR_STMT: expr_to(fs, n->expr_stmt.expr, dst); break;
+        case AST_ASSIGN:
+            compile_assign(fs, n);
+            load_name(fs, n, dst);
+            break;
+        case AST_IF: {
+            int cond = expr_any(fs, n->if_stmt.condition);
+            int jfalse = emit(fs, MAKE_ABx(OP_JMP_IF_NOT, cond, 0));
+            fs->free_reg = saved_reg;
+            memcpy(before, fs->assigned, sizeof(before));
+            stmt_value(fs, n->if_stmt.then_branch, dst);
+            int jend = emit(fs, MAKE_ABx(OP_JMP, 0, 0));
+            patch_jump(fs, jfalse, fs->p->code_size);
+            unsigned char then_assigned[MAX_REGS];
+            memcpy(then_assigned, fs->assigned, sizeof(then_assigned));
+            memcpy(fs->assigned, before, sizeof(before));
+            stmt_value(fs, n->if_stmt.else_branch, dst);
+            for (int i = 0; i < MAX_REGS; i++) fs->assigned[i] &= then_assigned[i];
+            patch_jump(fs, jend, fs->p->code_size);
+            break;
+        }
+        case AST_WHILE: {
+            emit(fs, MAKE_ABC(OP_LOADNIL, dst, 0, 0));
+            int start = fs->p->code_size;
+            int cond = expr_any(fs, n->while_stmt.condition);
+            int jexit = emit(fs, MAKE_ABx(OP_JMP_IF_NOT, cond, 0));
+            fs->free_reg = saved_reg;
+            memcpy(before, fs->assigned, sizeof(before));
+            stmt_value(fs, n->while_stmt.body, dst);
+            memcpy(fs->assigned, before, sizeof(before));
+            int jback = emit(fs, MAKE_ABx(OP_JMP, 0, 0));
+            patch_jump(fs, jback, start);
+            patch_jump(fs, jexit, fs->p->code_size);
+            break;
+        }
+        case AST_FOR: {
+            emit(fs, MAKE_ABC(OP_LOADNIL, dst, 0, 0));
+            int base = alloc_reg(fs);
+            alloc_reg(fs);  // indeks
+            alloc_reg(fs);  // panjang
+            alloc_reg(fs);  // elemen
+            expr_to(fs, n->for_stmt.iterable, base);
+            int jprep = emit(fs, MAKE_ABx(OP_FORPREP, base, 0));
+            int body = fs->p->code_size;
+            memcpy(before, fs->assigned, sizeof(before));
+            store_name(fs, n, base + 3);
+            stmt_value(fs, n->for_stmt.body, dst);
+            memcpy(fs->assigned, before, sizeof(before));
+            int jloop = emit(fs, MAKE_ABx(OP_FORLOOP, base, 0));
+            patch_jump(fs, jloop, body);
+            patch_jump(fs, jprep, jloop);
+            break;
+        }
+        case AST_FUNCTION:
+        case AST_RETURN:
+            compile_stmt(fs, n);
+            emit(fs, MAKE_ABC(OP_LOADNIL, dst, 0, 0));
+            break;
+        default:
+            expr_to(fs, n, dst);
+    }
+    fs->free_reg = saved_reg;
+    fs->line = saved_line;
+}
+
+// Badan fungsi/program. Seperti eval(), nilai statement terakhir menjadi
+// nilai kembali; ekspresi terakhir dikembalikan langsung tanpa MOVE.
+static void compile_body(FuncState* fs, ASTNode* body) {
+    ASTNode* last = NULL;
+    if (body && body->type == AST_BLOCK && body->block.count > 0) {
+        for (int i = 0; i < body->block.count - 1; i++) compile_stmt(fs, body->block.statements[i]);
+        last = body->block.statements[body->block.count - 1];
+    } else {
+        last = body;
+    }
+    if (!last) {
+        emit(fs, MAKE_ABC(OP_RETURN, 0, 0, 0));
+    } else if (last->type == AST_EXPR_STMT) {
+        fs->line = last->line;
+        emit(fs, MAKE_ABC(OP_RETURN, expr_any(fs, last->expr_stmt.expr), 1, 0));
+    } else {
+        int r = alloc_reg(fs);
+        stmt_value(fs, last, r);
+        fs->line = last->line;
+        emit(fs, MAKE_ABC(OP_RETURN, r, 1, 0));
+    }
+}
+
+static int compile_function(FuncState* fs, ASTNode* fn) {
+    Proto* p = proto_new(fn->function.name);
+    p->num_params = fn->function.param_count;
+    p->num_locals = fn->function.local_count;
+    p->own_env = fn->function.own_env;
+
+    // Ditautkan ke induk sebelum badannya dikompilasi, supaya proto_free()
+    // program juga melepas fungsi yang sedang dikompilasi saat error
+    Proto* parent = fs->p;
+    if (parent->num_protos > 0xFFFF) {
+        proto_free(p);
+        compile_error(fs, "Terlalu banyak fungsi");
+    }
+    parent->protos = realloc(parent->protos, sizeof(Proto*) * (parent->num_protos + 1));
+    parent->protos[parent->num_protos] = p;
+    int index = parent->num_protos++;
+
+    FuncState child = { fs, fs->err, p, fs->level + 1, 0, fn->line, {0} };
+    // Argumen selalu datang di R0..num_params-1; mode register juga
+    // menyimpan lokal lain di register sesudahnya.
+    child.free_reg = p->own_env ? p->num_params : p->num_locals;
+    if (child.free_reg > MAX_REGS) compile_error(&child, "Terlalu banyak variabel lokal");
+    for (int i = 0; i < p->num_params; i++) child.assigned[i] = 1;
+    p->max_regs = child.free_reg;
+    compile_body(&child, fn->function.body);
+    return index;
+}
+
+Proto* compile_program(ASTNode* ast, char* error) {
+    CompileErr err;
+    err.error = error;
+    err.program = proto_new("<utama>");
+    error[0] = '\0';
+    if (setjmp(err.on_error)) {
+        proto_free(err.program);
+        return NULL;
+    }
+    FuncState fs = { NULL, &err, err.program, 0, 0, ast ? ast->line : 0, {0} };
+    compile_body(&fs, ast);
+    return err.program;
+}
@@ -0,0 +1,16 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "parser.h"
+#include "regvm.h"
+
+// Turunkan AST yang sudah di-resolve (lihat resolver.h) ke bytecode
+// register. Alamat (depth, slot) dari resolver menentukan apakah sebuah
+// nama menjadi register, GETENV/SETENV, atau GETGLOBAL/SETGLOBAL.
+//
+// Error kompilasi tidak memanggil exit(): pesannya ditulis ke `error`
+// (COMPILE_ERROR_SIZE byte, sudah diakhiri '\n') dan hasilnya NULL.
+#define COMPILE_ERROR_SIZE 256
+Proto* compile_program(ASTNode* ast, char* error);
+
+#endif // COMPILER_H
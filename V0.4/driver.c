@@ -0,0 +1,127 @@
+#define _DEFAULT_SOURCE
+#include "driver.h"
+#include "source.h"
+#include "lexer.h"
+#include "parser.h"
+#include "resolver.h"
+#include "optimizer.h"
+#include "compiler.h"
+#include "vm.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    const char* path;
+    int ok;
+    int instructions;       // total instruksi termasuk fungsi bersarang
+    int functions;
+    char error[256];        // >= RESOLVE_ERROR_SIZE dan COMPILE_ERROR_SIZE
+} CompileJob;
+
+typedef struct {
+    CompileJob* jobs;
+    int count;
+    int next;               // job berikutnya yang belum diambil (atomik)
+} JobQueue;
+
+static void count_proto(Proto* p, CompileJob* job) {
+    job->instructions += p->code_size;
+    job->functions++;
+    for (int i = 0; i < p->num_protos; i++) count_proto(p->protos[i], job);
+}
+
+static void compile_one(CompileJob* job) {
+    SourceFile source;
+    if (!source_open(&source, job->path)) {
+        snprintf(job->error, sizeof(job->error), "Error: tidak bisa membuka file (%s)\n", strerror(errno));
+        return;
+    }
+    Arena arena;
+    arena_init(&arena);
+    Lexer lexer;
+    lexer_init(&lexer, source.data, source.length);
+    Parser parser;
+    parser_init(&parser, &arena, &lexer);
+    ASTNode* ast = parse(&parser);
+    source_close(&source);
+    if (!ast) {
+        memcpy(job->error, parser.error, sizeof(job->error));
+        arena_free(&arena);
+        return;
+    }
+
+    // Error resolve/compile dilaporkan lewat job->error seperti error
+    // parse, jadi file lain di thread pool tetap diproses
+    Environment* global = env_new(NULL, 0);
+    register_builtins(global);
+    if (resolve(ast, global, job->error)) {
+        ast = optimize(ast);
+        Proto* program = compile_program(ast, job->error);
+        if (program) {
+            count_proto(program, job);
+            job->ok = 1;
+            proto_free(program);
+        }
+    }
+    env_free(global);
+    arena_free(&arena);
+}
+
+static void* worker(void* arg) {
+    JobQueue* q = arg;
+    for (;;) {
+        int i = __atomic_fetch_add(&q->next, 1, __ATOMIC_RELAXED);
+        if (i >= q->count) break;
+        compile_one(&q->jobs[i]);
+    }
+    return NULL;
+}
+
+int compile_files(const char** paths, int count, int threads) {
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > count) threads = count;
+    if (threads < 1) threads = 1;
+
+    CompileJob* jobs = calloc(count, sizeof(CompileJob));
+    pthread_t* tids = malloc(sizeof(pthread_t) * threads);
+    if (!jobs || !tids) {
+        fprintf(stderr, "Error: Alokasi memori gagal untuk driver\n");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) jobs[i].path = paths[i];
+    JobQueue queue = { jobs, count, 0 };
+
+    // Thread pemanggil ikut bekerja; hanya threads-1 thread baru dibuat
+    int started = 0;
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&tids[started], NULL, worker, &queue) != 0) break;
+        started++;
+    }
+    worker(&queue);
+    for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        CompileJob* job = &jobs[i];
+        if (job->ok) {
+            printf("ok     %s (%d fungsi, %d instruksi)\n",
+                   job->path, job->functions, job->instructions);
+        } else {
+            printf("gagal  %s\n", job->path);
+            // stdout dikosongkan dulu supaya error muncul tepat di bawah
+            // baris statusnya walaupun stdout di-buffer (mis. ke pipe)
+            fflush(stdout);
+            fprintf(stderr, "%s: %s", job->path, job->error);
+            failed++;
+        }
+    }
+    printf("%d file, %d gagal, %d thread\n", count, failed, started + 1);
+
+    free(tids);
+    free(jobs);
+    return failed;
+}
@@ -0,0 +1,16 @@
+#ifndef DRIVER_H
+#define DRIVER_H
+
+// Kompilasi banyak file .niv sekaligus (nirvana -c): setiap file melewati
+// parse, resolve, optimize, dan compile_program() di thread pool berisi
+// `threads` pekerja (<= 0: jumlah core). Setiap file punya Lexer, Parser,
+// Arena, dan environment global sendiri; yang dibagi hanya tabel simbol.
+//
+// Pekerja tidak mencetak apa pun: hasil dicetak ke stdout sesuai urutan
+// `paths` setelah semua selesai. Error open, parse, resolve, dan compile
+// disimpan per file tanpa exit() lalu dicetak ke stderr dengan awalan
+// path, tepat di bawah baris statusnya.
+// Mengembalikan jumlah file yang gagal.
+int compile_files(const char** paths, int count, int threads);
+
+#endif // DRIVER_H
@@ -0,0 +1,90 @@
+#include "intern.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+typedef struct {
+    uint32_t hash;
+    int length;
+    char chars[];
+} Symbol;
+
+// Open addressing dengan probing linear; kapasitas selalu pangkat dua
+// dan diisi maksimal setengahnya.
+static Symbol** table = NULL;
+static int table_count = 0;
+static int table_capacity = 0;
+// Parser di beberapa thread (lihat driver.h) berbagi satu tabel supaya
+// simbol tetap bisa dibandingkan per pointer lintas file.
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hash_string(const char* s, int length) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (int i = 0; i < length; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void table_grow(void) {
+    int capacity = table_capacity ? table_capacity * 2 : 256;
+    Symbol** entries = calloc(capacity, sizeof(Symbol*));
+    if (!entries) {
+        fprintf(stderr, "Error: Alokasi memori gagal untuk tabel simbol\n");
+        exit(1);
+    }
+    for (int i = 0; i < table_capacity; i++) {
+        Symbol* sym = table[i];
+        if (!sym) continue;
+        uint32_t idx = sym->hash & (capacity - 1);
+        while (entries[idx]) idx = (idx + 1) & (capacity - 1);
+        entries[idx] = sym;
+    }
+    free(table);
+    table = entries;
+    table_capacity = capacity;
+}
+
+const char* intern(const char* s, int length) {
+    uint32_t hash = hash_string(s, length);
+    pthread_mutex_lock(&table_lock);
+    if ((table_count + 1) * 2 > table_capacity) table_grow();
+    uint32_t idx = hash & (table_capacity - 1);
+    Symbol* sym;
+    while ((sym = table[idx])) {
+        if (sym->hash == hash && sym->length == length &&
+            memcmp(sym->chars, s, length) == 0) {
+            pthread_mutex_unlock(&table_lock);
+            return sym->chars;
+        }
+        idx = (idx + 1) & (table_capacity - 1);
+    }
+    sym = malloc(sizeof(Symbol) + length + 1);
+    if (!sym) {
+        fprintf(stderr, "Error: Alokasi memori gagal untuk simbol\n");
+        exit(1);
+    }
+    sym->hash = hash;
+    sym->length = length;
+    memcpy(sym->chars, s, length);
+    sym->chars[length] = '\0';
+    table[idx] = sym;
+    table_count++;
+    pthread_mutex_unlock(&table_lock);
+    return sym->chars;
+}
+
+const char* intern_cstr(const char* s) {
+    return intern(s, (int)strlen(s));
+}
+
+void intern_free_all(void) {
+    for (int i = 0; i < table_capacity; i++) free(table[i]);
+    free(table);
+    table = NULL;
+    table_count = 0;
+    table_capacity = 0;
+}
@@ -0,0 +1,13 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+// Tabel simbol global (satu per proses): setiap nama dengan isi yang sama
+// dipetakan ke satu pointer kanonik. Dua simbol sama jika dan hanya jika
+// pointernya sama, jadi perbandingan nama cukup `a == b`, bukan strcmp.
+// String simbol dimiliki tabel dan hidup sampai intern_free_all().
+// intern() aman dipanggil dari beberapa thread; intern_free_all() tidak.
+const char* intern(const char* s, int length);
+const char* intern_cstr(const char* s);
+void intern_free_all(void);
+
+#endif // INTERN_H
@@ -1,31 +1,29 @@
 #include "lexer.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-#define MAX_INDENT_STACK 64
-static int indent_stack[MAX_INDENT_STACK];
-static int indent_top = 0;
-
-static void init_indent(void) {
-    indent_top = 0;
-    indent_stack[indent_top++] = 0;
-}
-
-static int get_current_indent(void) {
-    return indent_stack[indent_top - 1];
+static int get_current_indent(Lexer* lx) {
+    return lx->indent_stack[lx->indent_top - 1];
 }
 
-static void push_indent(int level) {
-    if (indent_top < MAX_INDENT_STACK) {
-        indent_stack[indent_top++] = level;
+static void push_indent(Lexer* lx, int level) {
+    if (lx->indent_top < MAX_INDENT_STACK) {
+        lx->indent_stack[lx->indent_top++] = level;
     }
 }
 
-static int pop_indent(void) {
-    if (indent_top > 1) {
-        return indent_stack[--indent_top];
+static int pop_indent(Lexer* lx) {
+    if (lx->indent_top > 1) {
+        return lx->indent_stack[--lx->indent_top];
     }
     return 0;
 }
@@ -34,63 +32,149 @@ static int is_identifier_char(char c) {
     return isalnum(c) || c == '_';
 }
 
+// -------------------------------------------------------------------
+// Jalur cepat pemindaian: 32 (AVX2) atau 16 (SSE2) byte sekaligus.
+// -------------------------------------------------------------------
+// Setiap pemindai mengembalikan pointer ke byte pertama yang TIDAK
+// termasuk kelasnya, dan tidak pernah membaca melewati `end` (akhir
+// input, posisi '\0'); sisa kurang dari satu vektor dikerjakan skalar.
+#if defined(__AVX2__)
+#define LEX_VEC 32
+typedef __m256i lexvec;
+#define VLOAD(p)        _mm256_loadu_si256((const __m256i*)(p))
+#define VSET1(c)        _mm256_set1_epi8((char)(c))
+#define VEQ(a, b)       _mm256_cmpeq_epi8(a, b)
+#define VGT(a, b)       _mm256_cmpgt_epi8(a, b)
+#define VAND(a, b)      _mm256_and_si256(a, b)
+#define VOR(a, b)       _mm256_or_si256(a, b)
+#define VMASK(v)        ((uint32_t)_mm256_movemask_epi8(v))
+#define VMASK_ALL       0xFFFFFFFFu
+#elif defined(__SSE2__)
+#define LEX_VEC 16
+typedef __m128i lexvec;
+#define VLOAD(p)        _mm_loadu_si128((const __m128i*)(p))
+#define VSET1(c)        _mm_set1_epi8((char)(c))
+#define VEQ(a, b)       _mm_cmpeq_epi8(a, b)
+#define VGT(a, b)       _mm_cmpgt_epi8(a, b)
+#define VAND(a, b)      _mm_and_si128(a, b)
+#define VOR(a, b)       _mm_or_si128(a, b)
+#define VMASK(v)        ((uint32_t)_mm_movemask_epi8(v))
+#define VMASK_ALL       0xFFFFu
+#endif
+
+#ifdef LEX_VEC
+// lo <= v <= hi. Perbandingan byte bertanda: byte >= 0x80 negatif dan
+// jatuh di luar semua rentang ASCII, sama seperti isalnum() di locale C.
+static inline lexvec vec_in_range(lexvec v, char lo, char hi) {
+    return VAND(VGT(v, VSET1(lo - 1)), VGT(VSET1(hi + 1), v));
+}
+#endif
+
+static const char* scan_identifier(const char* p, const char* end) {
+#ifdef LEX_VEC
+    while (end - p >= LEX_VEC) {
+        lexvec v = VLOAD(p);
+        lexvec ok = VOR(VOR(vec_in_range(v, 'a', 'z'), vec_in_range(v, 'A', 'Z')),
+                        VOR(vec_in_range(v, '0', '9'), VEQ(v, VSET1('_'))));
+        uint32_t mask = VMASK(ok);
+        if (mask != VMASK_ALL) return p + __builtin_ctz(~mask);
+        p += LEX_VEC;
+    }
+#endif
+    while (p < end && is_identifier_char(*p)) p++;
+    return p;
+}
+
+// Lewati spasi dan tab (bukan newline: newline adalah token).
+static const char* scan_blank(const char* p, const char* end) {
+#ifdef LEX_VEC
+    while (end - p >= LEX_VEC) {
+        lexvec v = VLOAD(p);
+        uint32_t mask = VMASK(VOR(VEQ(v, VSET1(' ')), VEQ(v, VSET1('\t'))));
+        if (mask != VMASK_ALL) return p + __builtin_ctz(~mask);
+        p += LEX_VEC;
+    }
+#endif
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+// Cari byte `a` atau `b` pertama; `end` bila tidak ada.
+static const char* scan_until(const char* p, const char* end, char a, char b) {
+#ifdef LEX_VEC
+    lexvec va = VSET1(a), vb = VSET1(b);
+    while (end - p >= LEX_VEC) {
+        lexvec v = VLOAD(p);
+        uint32_t mask = VMASK(VOR(VEQ(v, va), VEQ(v, vb)));
+        if (mask) return p + __builtin_ctz(mask);
+        p += LEX_VEC;
+    }
+#endif
+    while (p < end && *p != a && *p != b) p++;
+    return p;
+}
+
+// -------------------------------------------------------------------
+// Keyword: hash sempurna yang dihitung offline untuk 20 keyword di
+// bawah (tanpa tabrakan di 32 slot), jadi setiap identifier cukup satu
+// hash, satu perbandingan panjang, dan satu memcmp.
+// -------------------------------------------------------------------
+typedef struct {
+    const char* name;
+    int length;
+    TokenType type;
+} Keyword;
+
+static const Keyword keyword_table[32] = {
+    [2] = { "defi", 4, TOKEN_DEFI },
+    [3] = { "for", 3, TOKEN_UNTUK },
+    [5] = { "var", 3, TOKEN_VAR },
+    [6] = { "dalam", 5, TOKEN_DALAM },
+    [7] = { "maka", 4, TOKEN_MAKA },
+    [8] = { "salah", 5, TOKEN_SALAH },
+    [9] = { "selama", 6, TOKEN_SELAMA },
+    [10] = { "untuk", 5, TOKEN_UNTUK },
+    [11] = { "lain", 4, TOKEN_LAIN },
+    [12] = { "fungsi", 6, TOKEN_FUNGSI },
+    [13] = { "kembali", 7, TOKEN_KEMBALI },
+    [15] = { "null", 4, TOKEN_NULL },
+    [16] = { "false", 5, TOKEN_SALAH },
+    [17] = { "kosong", 6, TOKEN_NULL },
+    [20] = { "jika", 4, TOKEN_JIKA },
+    [21] = { "in", 2, TOKEN_DALAM },
+    [27] = { "true", 4, TOKEN_BENAR },
+    [28] = { "range", 5, TOKEN_RANGE },
+    [29] = { "benar", 5, TOKEN_BENAR },
+    [31] = { "cetak", 5, TOKEN_CETAK },
+};
+
+static inline unsigned keyword_hash(const unsigned char* s, int len) {
+    return (s[0] * 9u + s[1] + (unsigned)len * 4u + s[len - 1]) & 31u;
+}
+
 static TokenType check_keyword(const char* str, int len) {
     TokenType result = TOKEN_NAMA; // Default
-    
-    // Keywords existing
-    if (len == 5 && strncmp(str, "cetak", 5) == 0) result = TOKEN_CETAK;
-    else if (len == 4 && strncmp(str, "jika", 4) == 0) result = TOKEN_JIKA;
-    else if (len == 4 && strncmp(str, "maka", 4) == 0) result = TOKEN_MAKA;
-    else if (len == 4 && strncmp(str, "lain", 4) == 0) result = TOKEN_LAIN;
-    else if (len == 6 && strncmp(str, "selama", 6) == 0) result = TOKEN_SELAMA;
-    else if (len == 6 && strncmp(str, "fungsi", 6) == 0) result = TOKEN_FUNGSI;
-    else if (len == 4 && strncmp(str, "defi", 4) == 0) result = TOKEN_DEFI;
-    else if (len == 7 && strncmp(str, "kembali", 7) == 0) result = TOKEN_KEMBALI;
-    else if (len == 3 && strncmp(str, "var", 3) == 0) result = TOKEN_VAR;
-    
-    // Boolean keywords
-    else if (len == 5 && strncmp(str, "benar", 5) == 0) result = TOKEN_BENAR;
-    else if (len == 4 && strncmp(str, "true", 4) == 0) result = TOKEN_BENAR;
-    else if (len == 5 && strncmp(str, "salah", 5) == 0) result = TOKEN_SALAH;
-    else if (len == 5 && strncmp(str, "false", 5) == 0) result = TOKEN_SALAH;
-    else if (len == 5 && strncmp(str, "kosong", 5) == 0) result = TOKEN_NULL;
-    else if (len == 4 && strncmp(str, "null", 4) == 0) result = TOKEN_NULL;
-    
-    // NEW: For loop keywords
-    else if (len == 5 && strncmp(str, "untuk", 5) == 0) result = TOKEN_UNTUK;
-    else if (len == 3 && strncmp(str, "for", 3) == 0) result = TOKEN_UNTUK;
-    else if (len == 5 && strncmp(str, "dalam", 5) == 0) result = TOKEN_DALAM;
-    else if (len == 2 && strncmp(str, "in", 2) == 0) result = TOKEN_DALAM;
-    else if (len == 5 && strncmp(str, "range", 5) == 0) result = TOKEN_RANGE;
-    
-    // DEBUG PRINT
-    fprintf(stderr, "DEBUG: check_keyword - str: '%.*s', len: %d, returns TokenType: %d\n", len, str, len, result);
-    
+    if (len >= 2 && len <= 7) {
+        const Keyword* kw = &keyword_table[keyword_hash((const unsigned char*)str, len)];
+        if (kw->length == len && memcmp(kw->name, str, len) == 0) result = kw->type;
+    }
+    TRACE(TRACE_LEXER, TRACE_VERBOSE, "check_keyword '%.*s' -> token %d", len, str, result);
     return result;
 }
 
-Token* make_token(TokenType type, const char* start, int length, int line, int col) {
-    Token* t = malloc(sizeof(Token));
-    if (!t) {
-        fprintf(stderr, "Error: Alokasi memori gagal untuk Token\n");
-        exit(1);
-    }
-    t->type = type;
-    t->lexeme = malloc(length + 1);
-    if (!t->lexeme) {
-        fprintf(stderr, "Error: Alokasi memori gagal untuk lexeme\n");
-        free(t);
-        exit(1);
-    }
-    strncpy(t->lexeme, start, length);
-    t->lexeme[length] = '\0';
-    t->line = line;
-    t->column = col;
-    t->indent_level = get_current_indent();
+static Token new_token(Lexer* lx, TokenType type, const char* start, size_t length, int line, int col) {
+    Token t;
+    t.offset = (uint32_t)(start - lx->source);
+    t.length = (uint32_t)length;
+    t.line = line;
+    t.column = col;
+    t.type = (uint16_t)type;
+    t.indent_level = (uint16_t)get_current_indent(lx);
+    lx->token_count++;
     return t;
 }
 
-void print_token(Token* token) {
+void print_token(const Lexer* lx, const Token* token) {
     const char* type_str = "UNKNOWN";
     switch (token->type) {
         case TOKEN_STRING: type_str = "STRING"; break;
@@ -145,78 +229,98 @@ void print_token(Token* token) {
         case TOKEN_EOF: type_str = "EOF"; break;
         case TOKEN_ERROR: type_str = "ERROR"; break;
     }
-    printf("[%d:%d] %-12s '%s' (indent:%d)\n", 
-           token->line, token->column, type_str, token->lexeme, token->indent_level);
+    printf("[%d:%d] %-12s '%.*s' (indent:%d)\n", 
+           token->line, token->column, type_str, (int)token->length,
+           token_text(lx, token), token->indent_level);
 }
 
-void free_token(Token* token) {
-    if (token) {
-        free(token->lexeme);
-        free(token);
-    }
+void lexer_init(Lexer* lx, const char* source, size_t length) {
+    lx->source = source;
+    lx->current = source;
+    lx->end = source + length;
+    lx->line = 1;
+    lx->col = 1;
+    lx->at_line_start = 1;
+    lx->dedent_to = -1;
+    lx->indent_top = 0;
+    lx->indent_stack[lx->indent_top++] = 0;
+    lx->token_count = 0;
 }
 
-#define CHECK_CAP if (count + 1 >= capacity) { \
-    capacity *= 2; \
-    token_counts = realloc(token_counts, sizeof(Token*) * capacity); \
-}
+Token lexer_next(Lexer* lx) {
+    const char* current = lx->current;
+    const char* end = lx->end;
+    int line = lx->line, col = lx->col;
+    Token tok;
 
-#define EMIT_TOKEN(t) do { CHECK_CAP; token_counts[count++] = (t); } while(0)
+// Simpan posisi pemindaian kembali ke lexer lalu kembalikan token.
+#define RETURN_TOKEN(t) do { \
+        tok = (t); \
+        lx->current = current; lx->line = line; lx->col = col; \
+        return tok; \
+    } while (0)
 
-Token** lex(const char* input, int* token_count) {
-    int capacity = 16;
-    Token** token_counts = malloc(sizeof(Token*) * capacity);
-    int count = 0;
-    const char* current = input;
-    int line = 1, col = 1;
-    int at_line_start = 1;
-    
-    init_indent();
+    // DEDENT tertunda dikeluarkan satu per panggilan.
+    if (lx->dedent_to >= 0) {
+        if (lx->dedent_to < get_current_indent(lx)) {
+            pop_indent(lx);
+            RETURN_TOKEN(new_token(lx, TOKEN_DEDENT, current, 0, line, col));
+        }
+        lx->dedent_to = -1;
+    }
     
     while (*current != '\0') {
         // Handle indentation at line start
-        if (at_line_start) {
-            int spaces = 0;
-            while (*current == ' ' || *current == '\t') {
-                if (*current == ' ') spaces += 1;
-                else spaces += 4;
-                current++;
-                col++;
+        if (lx->at_line_start) {
+            const char* start = current;
+            current = scan_blank(current, end);
+            int spaces = current - start;
+            for (const char* p = start; p < current; p++) {
+                if (*p == '\t') spaces += 3;   // tab = 4 spasi
             }
+            col += current - start;
             
             // Skip empty lines and comments
-            if (*current == '\n' || *current == '#') {
+            if (*current == '#') {
+                const char* eol = scan_until(current, end, '\n', '\n');
+                col += eol - current;
+                current = eol;
+            }
+            if (*current == '\n' || *current == '\0') {
                 if (*current == '\n') { line++; col = 1; current++; }
                 continue;
             }
             
             int indent_level = spaces / 4;
-            int current_level = get_current_indent();
+            int current_level = get_current_indent(lx);
+            lx->at_line_start = 0;
             
             if (indent_level > current_level) {
-                push_indent(indent_level);
-                EMIT_TOKEN(make_token(TOKEN_INDENT, "", 0, line, col));
+                push_indent(lx, indent_level);
+                RETURN_TOKEN(new_token(lx, TOKEN_INDENT, current, 0, line, col));
             } else if (indent_level < current_level) {
-                while (indent_level < get_current_indent()) {
-                    pop_indent();
-                    EMIT_TOKEN(make_token(TOKEN_DEDENT, "", 0, line, col));
-                }
+                pop_indent(lx);
+                lx->dedent_to = indent_level;
+                RETURN_TOKEN(new_token(lx, TOKEN_DEDENT, current, 0, line, col));
             }
-            
-            at_line_start = 0;
         }
         
         // Newline
         if (*current == '\n') {
             line++;
             col = 1;
-            at_line_start = 1;
-            EMIT_TOKEN(make_token(TOKEN_NEWLINE, "\n", 1, line, col));
+            lx->at_line_start = 1;
             current++;
-            continue;
+            RETURN_TOKEN(new_token(lx, TOKEN_NEWLINE, current - 1, 1, line, col));
         }
         
         // Whitespace
+        if (*current == ' ' || *current == '\t') {
+            const char* next = scan_blank(current, end);
+            col += next - current;
+            current = next;
+            continue;
+        }
         if (isspace(*current)) {
             col++;
             current++;
@@ -225,10 +329,9 @@ Token** lex(const char* input, int* token_count) {
         
         // Comment
         if (*current == '#') {
-            while (*current != '\n' && *current != '\0') {
-                current++;
-                col++;
-            }
+            const char* eol = scan_until(current, end, '\n', '\n');
+            col += eol - current;
+            current = eol;
             continue;
         }
         
@@ -238,13 +341,11 @@ Token** lex(const char* input, int* token_count) {
         if (*current == '"') {
             current++; col++;
             const char* start = current;
-            int len = 0;
-            while (*current != '"' && *current != '\0' && *current != '\n') {
-                current++; len++; col++;
-            }
-            EMIT_TOKEN(make_token(TOKEN_STRING, start, len, line, start_col));
+            current = scan_until(current, end, '"', '\n');
+            int len = current - start;
+            col += len;
             if (*current == '"') { current++; col++; }
-            continue;
+            RETURN_TOKEN(new_token(lx, TOKEN_STRING, start, len, line, start_col));
         }
         
         // Number
@@ -257,44 +358,43 @@ Token** lex(const char* input, int* token_count) {
                 current++; col++;
                 while (isdigit(*current)) { current++; col++; }
             }
-            EMIT_TOKEN(make_token(is_float ? TOKEN_FLOAT : TOKEN_NOMER, 
-                                   start, current - start, line, start_col));
-            continue;
+            RETURN_TOKEN(new_token(lx, is_float ? TOKEN_FLOAT : TOKEN_NOMER,
+                                    start, current - start, line, start_col));
         }
         
         // Identifier/Keyword
         if (isalpha(*current) || *current == '_') {
             const char* start = current;
-            while (is_identifier_char(*current)) { current++; col++; }
+            current = scan_identifier(current, end);
             int len = current - start;
-            EMIT_TOKEN(make_token(check_keyword(start, len), start, len, line, start_col));
-            continue;
+            col += len;
+            RETURN_TOKEN(new_token(lx, check_keyword(start, len), start, len, line, start_col));
         }
         
         // Two-char operators
         if (*current == '=' && *(current+1) == '=') {
-            EMIT_TOKEN(make_token(TOKEN_EQ, current, 2, line, start_col));
-            current += 2; col += 2; continue;
+            current += 2; col += 2;
+            RETURN_TOKEN(new_token(lx, TOKEN_EQ, current - 2, 2, line, start_col));
         }
         if (*current == '!' && *(current+1) == '=') {
-            EMIT_TOKEN(make_token(TOKEN_NEQ, current, 2, line, start_col));
-            current += 2; col += 2; continue;
+            current += 2; col += 2;
+            RETURN_TOKEN(new_token(lx, TOKEN_NEQ, current - 2, 2, line, start_col));
         }
         if (*current == '<' && *(current+1) == '=') {
-            EMIT_TOKEN(make_token(TOKEN_LTE, current, 2, line, start_col));
-            current += 2; col += 2; continue;
+            current += 2; col += 2;
+            RETURN_TOKEN(new_token(lx, TOKEN_LTE, current - 2, 2, line, start_col));
         }
         if (*current == '>' && *(current+1) == '=') {
-            EMIT_TOKEN(make_token(TOKEN_GTE, current, 2, line, start_col));
-            current += 2; col += 2; continue;
+            current += 2; col += 2;
+            RETURN_TOKEN(new_token(lx, TOKEN_GTE, current - 2, 2, line, start_col));
         }
         if (*current == '&' && *(current+1) == '&') {
-            EMIT_TOKEN(make_token(TOKEN_AND, current, 2, line, start_col));
-            current += 2; col += 2; continue;
+            current += 2; col += 2;
+            RETURN_TOKEN(new_token(lx, TOKEN_AND, current - 2, 2, line, start_col));
         }
         if (*current == '|' && *(current+1) == '|') {
-            EMIT_TOKEN(make_token(TOKEN_OR, current, 2, line, start_col));
-            current += 2; col += 2; continue;
+            current += 2; col += 2;
+            RETURN_TOKEN(new_token(lx, TOKEN_OR, current - 2, 2, line, start_col));
         }
         
         // Single char tokens
@@ -323,17 +423,17 @@ Token** lex(const char* input, int* token_count) {
             case '.': type = TOKEN_TITIK; break;
         }
         
-        EMIT_TOKEN(make_token(type, current, 1, line, start_col));
         current++; col++;
+        RETURN_TOKEN(new_token(lx, type, current - 1, 1, line, start_col));
     }
     
-    // Emit remaining DEDENTs
-    while (get_current_indent() > 0) {
-        pop_indent();
-        EMIT_TOKEN(make_token(TOKEN_DEDENT, "", 0, line, col));
+    // Emit remaining DEDENTs, satu per panggilan
+    if (get_current_indent(lx) > 0) {
+        pop_indent(lx);
+        RETURN_TOKEN(new_token(lx, TOKEN_DEDENT, current, 0, line, col));
     }
     
-    EMIT_TOKEN(make_token(TOKEN_EOF, "", 0, line, col));
-    *token_count = count;
-    return token_counts;
+    TRACE(TRACE_LEXER, TRACE_INFO, "EOF setelah %d token", lx->token_count);
+    RETURN_TOKEN(new_token(lx, TOKEN_EOF, current, 0, line, col));
+#undef RETURN_TOKEN
 }
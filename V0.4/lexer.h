@@ -1,6 +1,9 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef enum {
     // Literals
     TOKEN_STRING,
@@ -71,17 +74,44 @@ typedef enum {
     TOKEN_ERROR
 } TokenType;
 
+// Token berukuran tetap tanpa pointer: lexeme adalah rentang
+// [offset, offset + length) di sumber (lihat token_text()). Nilai string
+// dan angka baru didekode parser saat node AST dibuat.
 typedef struct {
-    TokenType type;
-    char* lexeme;
+    uint32_t offset;
+    uint32_t length;
     int line;
     int column;
-    int indent_level;
+    uint16_t type;          // TokenType
+    uint16_t indent_level;
 } Token;
 
-Token** lex(const char* input, int* token_count);
-void print_token(Token* token);
-void free_token(Token* token);
-Token* make_token(TokenType type, const char* start, int length, int line, int col);
+#define MAX_INDENT_STACK 64
+
+// Lexer pull: lexer_next() memindai sumber hanya sampai token berikutnya,
+// jadi memori token O(lookahead pemanggil), bukan O(file). Lexer tidak
+// mengalokasikan apa pun; sumber harus tetap hidup selama token dipakai.
+typedef struct {
+    const char* source;
+    const char* current;
+    const char* end;            // source + length; *end harus '\0'
+    int line;
+    int col;
+    int at_line_start;
+    int dedent_to;              // >= 0: DEDENT tertunda sampai level ini
+    int indent_stack[MAX_INDENT_STACK];
+    int indent_top;
+    int token_count;
+} Lexer;
+
+// source[length] harus '\0' (lihat SourceFile di source.h).
+void lexer_init(Lexer* lx, const char* source, size_t length);
+// Setelah TOKEN_EOF, panggilan berikutnya terus mengembalikan TOKEN_EOF.
+Token lexer_next(Lexer* lx);
+void print_token(const Lexer* lx, const Token* token);
+
+static inline const char* token_text(const Lexer* lx, const Token* token) {
+    return lx->source + token->offset;
+}
 
 #endif
@@ -1,66 +1,145 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "lexer.h"
 #include "parser.h"
 #include "vm.h"
+#include "resolver.h"
+#include "compiler.h"
+#include "optimizer.h"
+#include "trace.h"
+#include "intern.h"
+#include "source.h"
+#include "driver.h"
 
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Penggunaan: %s <nama_file>\n", argv[0]);
+    // -b / --bytecode: jalankan lewat register VM, bukan eval()
+    int use_bytecode = 0;
+    // -c / --compile: hanya kompilasi semua file, paralel (-j N thread)
+    int compile_only = 0;
+    int threads = 0;
+    const char** paths = malloc(sizeof(const char*) * argc);
+    int path_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "--bytecode") == 0) use_bytecode = 1;
+        else if (strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--compile") == 0) compile_only = 1;
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            // --trace=lexer,parser[:level]: jejak dicetak ke stderr saat keluar
+            if (!trace_configure(argv[i] + 8)) {
+                fprintf(stderr, "Error: --trace tidak dikenal atau build tanpa -DNIRVANA_TRACE\n");
+                return 1;
+            }
+        }
+        else paths[path_count++] = argv[i];
+    }
+    if (path_count == 0) {
+        fprintf(stderr, "Penggunaan: %s [-b|--bytecode] [--trace=kategori[:level]] <nama_file>\n"
+                        "            %s -c [-j N] <nama_file>...\n", argv[0], argv[0]);
+        return 1;
+    }
+    if (!compile_only && path_count > 1) {
+        fprintf(stderr, "Error: hanya satu file yang bisa dijalankan; pakai -c untuk banyak file\n");
+        free(paths);
         return 1;
     }
+    if (compile_only) {
+        int failed = compile_files(paths, path_count, threads);
+        free(paths);
+        intern_free_all();
+        return failed ? 1 : 0;
+    }
+    const char* path = paths[0];
+    free(paths);
 
-    // Baca file
-    FILE* f = fopen(argv[1], "r");
-    if (!f) {
-        perror("fopen");
+    // Petakan file (mmap); token menunjuk langsung ke pemetaan ini
+    SourceFile source;
+    if (!source_open(&source, path)) {
+        perror(path);
         return 1;
     }
-    fseek(f, 0, SEEK_END);
-    long len = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    char* input = malloc(len + 1);
-    fread(input, 1, len, f);
-    input[len] = '\0';
-    fclose(f);
 
-    // Lexing
-    int token_count;
-    Token** tokens = lex(input, &token_count);
+    // Arena kompilasi: string literal dan AST file ini
+    Arena arena;
+    arena_init(&arena);
+
+    // Dump token: satu lintasan lexer yang hanya dicetak
+    Lexer lexer;
+    lexer_init(&lexer, source.data, source.length);
     printf("Token-token:\n");
-    for (int i = 0; i < token_count; i++) {
-        print_token(tokens[i]);
+    for (;;) {
+        Token t = lexer_next(&lexer);
+        print_token(&lexer, &t);
+        if (t.type == TOKEN_EOF) break;
     }
 
-    // Parsing
-    parser_init(tokens, token_count);
-    ASTNode* ast = parse();
+    // Parsing: parser menarik token langsung dari lexer. Setelah itu AST
+    // tidak lagi menunjuk ke sumber, jadi pemetaan bisa dilepas.
+    lexer_init(&lexer, source.data, source.length);
+    Parser parser;
+    parser_init(&parser, &arena, &lexer);
+    ASTNode* ast = parse(&parser);
+    source_close(&source);
+    if (!ast) {
+        fputs(parser.error, stderr);
+        arena_free(&arena);
+        intern_free_all();
+        return 1;
+    }
     printf("\nAST:\n");
     print_ast(ast, 0);
 
     // Environment global
-    Environment* global = env_new(NULL);
-    // Daftarkan fungsi bawaan
-    env_set(global, "cetak", value_native("cetak", native_print));
-    env_set(global, "range", value_native("range", native_range));
-    env_set(global, "print", value_native("print", native_print)); // English version
+    Environment* global = env_new(NULL, 0);
+    register_builtins(global);
+
+    // Resolusi nama -> (depth, slot)
+    char error[RESOLVE_ERROR_SIZE];
+    if (!resolve(ast, global, error)) {
+        fputs(error, stderr);
+        env_free(global);
+        arena_free(&arena);
+        intern_free_all();
+        return 1;
+    }
+
+    // Lipat konstanta dan buang cabang mati (dipakai kedua mesin)
+    ast = optimize(ast);
 
     // Eksekusi
-    printf("\nHasil Eksekusi:\n");
-    bool returned_flag = false;
-    Value result = eval(ast, global, &returned_flag);
+    Value result;
+    if (use_bytecode) {
+        char compile_error[COMPILE_ERROR_SIZE];
+        Proto* program = compile_program(ast, compile_error);
+        if (!program) {
+            fputs(compile_error, stderr);
+            env_free(global);
+            arena_free(&arena);
+            intern_free_all();
+            return 1;
+        }
+        printf("\nBytecode:");
+        proto_print(program);
+        printf("\nHasil Eksekusi:\n");
+        result = regvm_run(program, global);
+        proto_free(program);
+    } else {
+        printf("\nHasil Eksekusi:\n");
+        bool returned_flag = false;
+        result = eval(ast, global, &returned_flag);
+    }
     printf("Nilai kembali: ");
     print_value(result);
     printf("\n");
 
     // Pembersihan
     value_free(result);
-    free_ast(ast);
-    for (int i = 0; i < token_count; i++) free_token(tokens[i]);
-    free(tokens);
-    free(input);
     env_free(global);
+    env_free_escaped();
+    frame_stack_free();
+    arena_free(&arena);
+    intern_free_all();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "optimizer.h"
+#include "vm.h"
+#include <limits.h>
+
+static int is_numeric(ASTNode* n) {
+    return n->type == AST_NUMBER || n->type == AST_FLOAT;
+}
+
+static int is_literal(ASTNode* n) {
+    switch (n->type) {
+        case AST_NUMBER:
+        case AST_FLOAT:
+        case AST_STRING:
+        case AST_BOOLEAN:
+        case AST_NULL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Sama dengan is_truthy() untuk nilai literal, tanpa membuat Value.
+static int literal_truthy(ASTNode* n) {
+    switch (n->type) {
+        case AST_NUMBER: return n->number != 0;
+        case AST_FLOAT: return n->float_num != 0.0;
+        case AST_STRING: return n->string[0] != '\0';
+        case AST_BOOLEAN: return n->boolean;
+        default: return 0;
+    }
+}
+
+static Value literal_value(ASTNode* n) {
+    if (n->type == AST_NUMBER) return value_number(n->number);
+    if (n->type == AST_FLOAT) return value_float(n->float_num);
+    return value_boolean(literal_truthy(n));
+}
+
+// Ganti isi node dengan literal hasil lipatan (line tetap).
+static void set_literal(ASTNode* n, Value v) {
+    switch (v.type) {
+        case VAL_NUMBER: n->type = AST_NUMBER; n->number = v.number; break;
+        case VAL_FLOAT: n->type = AST_FLOAT; n->float_num = v.float_num; break;
+        case VAL_BOOLEAN: n->type = AST_BOOLEAN; n->boolean = v.boolean; break;
+        default: n->type = AST_NULL; break;
+    }
+}
+
+// Pasti bernilai angka saat runtime: literal angka, minus unary (non-angka
+// adalah error), atau + - * / yang selalu menghasilkan angka dari
+// value_binary (operan non-angka dihitung 0). % tidak: float % float = nil.
+static int is_numeric_expr(ASTNode* n) {
+    if (is_numeric(n)) return 1;
+    if (n->type == AST_UNARY) return n->unary.op == TOKEN_MINUS;
+    if (n->type != AST_BINARY) return 0;
+    switch (n->binary.op) {
+        case TOKEN_PLUS: case TOKEN_MINUS: case TOKEN_BINTANG: case TOKEN_GARING:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int is_int_literal(ASTNode* n, int k) {
+    return n->type == AST_NUMBER && n->number == k;
+}
+
+static ASTNode* fold_binary(ASTNode* n) {
+    ASTNode* l = n->binary.left;
+    ASTNode* r = n->binary.right;
+    TokenType op = n->binary.op;
+    if (is_numeric(l) && is_numeric(r)) {
+        // Pembagian int dengan nol (atau INT_MIN / -1) adalah trap di C:
+        // biarkan terjadi di runtime seperti sebelumnya.
+        if ((op == TOKEN_GARING || op == TOKEN_PERSEN) &&
+            l->type == AST_NUMBER && r->type == AST_NUMBER &&
+            (r->number == 0 || (l->number == INT_MIN && r->number == -1))) {
+            return n;
+        }
+        set_literal(n, value_binary(op, literal_value(l), literal_value(r), n->line));
+        return n;
+    }
+    // Identitas dengan literal int 0/1, hanya bila x pasti angka: untuk
+    // string/boolean/array `x + 0` bernilai angka 0, bukan x. x tetap
+    // dievaluasi sehingga efek sampingnya tidak hilang.
+    switch (op) {
+        case TOKEN_PLUS:
+            if (is_int_literal(r, 0) && is_numeric_expr(l)) return l;
+            if (is_int_literal(l, 0) && is_numeric_expr(r)) return r;
+            break;
+        case TOKEN_MINUS:
+            if (is_int_literal(r, 0) && is_numeric_expr(l)) return l;
+            break;
+        case TOKEN_BINTANG:
+            if (is_int_literal(r, 1) && is_numeric_expr(l)) return l;
+            if (is_int_literal(l, 1) && is_numeric_expr(r)) return r;
+            break;
+        case TOKEN_GARING:
+            if (is_int_literal(r, 1) && is_numeric_expr(l)) return l;
+            break;
+        default:
+            break;
+    }
+    return n;
+}
+
+static ASTNode* fold_unary(ASTNode* n) {
+    ASTNode* operand = n->unary.operand;
+    if (n->unary.op == TOKEN_MINUS && is_numeric(operand)) {
+        set_literal(n, value_unary(TOKEN_MINUS, literal_value(operand), n->line));
+    } else if (n->unary.op == TOKEN_NOT && is_literal(operand)) {
+        set_literal(n, value_boolean(!literal_truthy(operand)));
+    }
+    return n;
+}
+
+// Statement literal di tengah blok tidak berefek; yang terakhir tetap
+// disimpan karena menjadi nilai blok (nilai kembali implisit).
+static int is_dead_stmt(ASTNode* n) {
+    if (n->type == AST_EXPR_STMT) n = n->expr_stmt.expr;
+    return is_literal(n);
+}
+
+static ASTNode* opt(ASTNode* n) {
+    if (!n) return NULL;
+    switch (n->type) {
+        case AST_ARRAY:
+            for (int i = 0; i < n->array.count; i++) {
+                n->array.elements[i] = opt(n->array.elements[i]);
+            }
+            return n;
+        case AST_BINARY:
+            n->binary.left = opt(n->binary.left);
+            n->binary.right = opt(n->binary.right);
+            return fold_binary(n);
+        case AST_UNARY:
+            n->unary.operand = opt(n->unary.operand);
+            return fold_unary(n);
+        case AST_ASSIGN:
+            n->assign.value = opt(n->assign.value);
+            return n;
+        case AST_CALL:
+            for (int i = 0; i < n->call.arg_count; i++) {
+                n->call.args[i] = opt(n->call.args[i]);
+            }
+            return n;
+        case AST_INDEX:
+            n->index.object = opt(n->index.object);
+            n->index.index = opt(n->index.index);
+            return n;
+        case AST_BLOCK: {
+            int count = 0;
+            for (int i = 0; i < n->block.count; i++) {
+                ASTNode* stmt = opt(n->block.statements[i]);
+                if (i < n->block.count - 1 && is_dead_stmt(stmt)) continue;
+                n->block.statements[count++] = stmt;
+            }
+            n->block.count = count;
+            return n;
+        }
+        case AST_IF:
+            n->if_stmt.condition = opt(n->if_stmt.condition);
+            n->if_stmt.then_branch = opt(n->if_stmt.then_branch);
+            n->if_stmt.else_branch = opt(n->if_stmt.else_branch);
+            if (is_literal(n->if_stmt.condition)) {
+                ASTNode* taken = literal_truthy(n->if_stmt.condition)
+                    ? n->if_stmt.then_branch : n->if_stmt.else_branch;
+                if (taken) return taken;
+                n->type = AST_NULL;   // jika tanpa lain bernilai kosong
+            }
+            return n;
+        case AST_WHILE:
+            n->while_stmt.condition = opt(n->while_stmt.condition);
+            n->while_stmt.body = opt(n->while_stmt.body);
+            if (is_literal(n->while_stmt.condition) && !literal_truthy(n->while_stmt.condition)) {
+                n->type = AST_NULL;
+            }
+            return n;
+        case AST_FOR:
+            n->for_stmt.iterable = opt(n->for_stmt.iterable);
+            n->for_stmt.body = opt(n->for_stmt.body);
+            return n;
+        case AST_FUNCTION:
+            n->function.body = opt(n->function.body);
+            return n;
+        case AST_RETURN:
+            n->return_stmt.value = opt(n->return_stmt.value);
+            return n;
+        case AST_EXPR_STMT:
+            n->expr_stmt.expr = opt(n->expr_stmt.expr);
+            return n;
+        default:
+            return n;
+    }
+}
+
+ASTNode* optimize(ASTNode* ast) {
+    return opt(ast);
+}
@@ -0,0 +1,18 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "parser.h"
+
+// Pass antara resolve() dan eksekusi (eval() maupun compile_program()):
+// - melipat operasi literal angka (`2 * 3`, `1 < 2`, `-4`, `!0`),
+// - membuang cabang `jika` dengan kondisi konstan dan `selama` yang
+//   kondisinya selalu salah,
+// - menyederhanakan identitas `x + 0`, `0 + x`, `x - 0`, `x * 1`,
+//   `1 * x`, dan `x / 1`.
+// Hasil lipatan dihitung dengan value_binary()/value_unary() yang sama
+// dengan runtime, jadi nilainya identik dengan yang dihitung eval().
+// Operasi yang di runtime berupa error (mis. bagi nol) tidak dilipat.
+// Node diubah di tempat, sehingga alamat (depth, slot) tetap berlaku.
+ASTNode* optimize(ASTNode* ast);
+
+#endif // OPTIMIZER_H
@@ -2,198 +2,221 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <setjmp.h>
 #include "parser.h"
 #include "lexer.h"
+#include "trace.h"
+#include "intern.h"
 
-static Token** tokens;
-static int token_count;
-static int pos = 0;
+// Jendela token: cur() dan satu token lookahead ditarik dari lexer sesuai
+// kebutuhan (lihat Parser.ring di parser.h).
+static Token* peek(Parser* p, int ahead) {
+    while (p->filled <= p->pos + ahead) {
+        p->ring[p->filled++ % PARSER_LOOKAHEAD] = lexer_next(p->lexer);
+    }
+    return &p->ring[(p->pos + ahead) % PARSER_LOOKAHEAD];
+}
 
-static void error(const char* msg) {
-    fprintf(stderr, "Parse Error [%d:%d]: %s\n", tokens[pos]->line, 
-            tokens[pos]->column, msg);
-    fprintf(stderr, "  Near: '%s'\n", tokens[pos]->lexeme);
-    exit(1);
+// Token hanya berisi offset ke sumber; teks dan nilainya diambil di sini
+// saat node AST membutuhkannya.
+static const char* text(Parser* p, Token* t) { return token_text(p->lexer, t); }
+static const char* name_of(Parser* p, Token* t) { return intern(text(p, t), (int)t->length); }
+
+// Digit NOMER selalu diikuti byte bukan digit (paling tidak '\0' sentinel
+// sumber), jadi atoi() bisa langsung membaca dari sumber. FLOAT disalin
+// dulu agar atof() tidak ikut membaca "e3" pada "1.5e3" (dua token).
+static double float_value(Parser* p, Token* t) {
+    char buf[64];
+    if (t->length >= sizeof(buf)) return atof(arena_strndup(p->arena, text(p, t), t->length));
+    memcpy(buf, text(p, t), t->length);
+    buf[t->length] = '\0';
+    return atof(buf);
 }
 
-char* my_strdup(const char* s) {
-    char* d = malloc(strlen(s) + 1);
-    if (d) strcpy(d, s);
-    return d;
+// Error parse tidak lagi exit(): pesan disimpan di p->error lalu
+// longjmp kembali ke parse(), sehingga satu file yang rusak tidak
+// menghentikan thread lain yang sedang mem-parse file lain.
+static void error(Parser* p, const char* msg) {
+    Token* t = peek(p, 0);
+    snprintf(p->error, sizeof(p->error), "Parse Error [%d:%d]: %s\n  Near: '%.*s'\n",
+             t->line, t->column, msg, (int)t->length, text(p, t));
+    longjmp(p->on_error, 1);
 }
 
-ASTNode* make_node(ASTType type) {
-    ASTNode* n = calloc(1, sizeof(ASTNode));
+ASTNode* make_node(Parser* p, ASTType type) {
+    ASTNode* n = arena_alloc(p->arena, sizeof(ASTNode));
+    memset(n, 0, sizeof(ASTNode));
     n->type = type;
-    n->line = tokens[pos]->line;
+    n->line = peek(p, 0)->line;
     return n;
 }
 
-static Token* cur() { return tokens[pos]; }
-static Token* adv() { Token* t = cur(); if (t->type != TOKEN_EOF) pos++; return t; }
-static int chk(TokenType t) { return cur()->type == t; }
-static int mat(TokenType t) { if (chk(t)) { adv(); return 1; } return 0; }
+static Token* cur(Parser* p) { return peek(p, 0); }
+static Token* adv(Parser* p) { Token* t = cur(p); if (t->type != TOKEN_EOF) p->pos++; return t; }
+static int chk(Parser* p, TokenType t) { return cur(p)->type == t; }
+static int mat(Parser* p, TokenType t) { if (chk(p, t)) { adv(p); return 1; } return 0; }
 
-static Token* consume(TokenType type) {
-    if (chk(type)) return adv();
-    fprintf(stderr, "Expected token type %d\n", type);
-    exit(1);
-    return NULL;
+static Token* consume(Parser* p, TokenType type) {
+    if (chk(p, type)) return adv(p);
+    snprintf(p->error, sizeof(p->error), "Expected token type %d\n", type);
+    longjmp(p->on_error, 1);
 }
 
-static void skip_ws() {
-    while (chk(TOKEN_NEWLINE) || chk(TOKEN_INDENT) || chk(TOKEN_DEDENT)) adv();
+static void skip_ws(Parser* p) {
+    while (chk(p, TOKEN_NEWLINE) || chk(p, TOKEN_INDENT) || chk(p, TOKEN_DEDENT)) adv(p);
 }
 
 // Forward declarations
-static ASTNode* parse_stmt();
-static ASTNode* parse_expr();
-static ASTNode* parse_block();
+static ASTNode* parse_stmt(Parser* p);
+static ASTNode* parse_expr(Parser* p);
+static ASTNode* parse_block(Parser* p);
 
 // === EXPRESSION PARSING ===
 
 // NEW: Parse array literal [1, 2, 3]
-static ASTNode* parse_array() {
-    mat(TOKEN_BUKA_KOTAK);  // consume [
+static ASTNode* parse_array(Parser* p) {
+    mat(p, TOKEN_BUKA_KOTAK);  // consume [
     
-    ASTNode* node = make_node(AST_ARRAY);
+    ASTNode* node = make_node(p, AST_ARRAY);
     int cap = 4;
-    node->array.elements = malloc(sizeof(ASTNode*) * cap);
+    node->array.elements = arena_alloc(p->arena, sizeof(ASTNode*) * cap);
     node->array.count = 0;
     
     // Empty array []
-    if (chk(TOKEN_TUTUP_KOTAK)) {
-        adv();
+    if (chk(p, TOKEN_TUTUP_KOTAK)) {
+        adv(p);
         return node;
     }
     
     // Parse elements
     do {
         if (node->array.count >= cap) {
+            node->array.elements = arena_grow(p->arena, node->array.elements, sizeof(ASTNode*) * cap,
+                                              sizeof(ASTNode*) * cap * 2);
             cap *= 2;
-            node->array.elements = realloc(node->array.elements, sizeof(ASTNode*) * cap);
         }
-        node->array.elements[node->array.count++] = parse_expr();
-    } while (mat(TOKEN_KOMA));
+        node->array.elements[node->array.count++] = parse_expr(p);
+    } while (mat(p, TOKEN_KOMA));
     
-    if (!mat(TOKEN_TUTUP_KOTAK)) {
-        error("Expected ']' to close array");
+    if (!mat(p, TOKEN_TUTUP_KOTAK)) {
+        error(p, "Expected ']' to close array");
     }
     
     return node;
 }
 
-static ASTNode* parse_primary() {
-    Token* t = cur();
+static ASTNode* parse_primary(Parser* p) {
+    Token* t = cur(p);
     
     // NEW: Array literal
-    if (chk(TOKEN_BUKA_KOTAK)) {
-        return parse_array();
+    if (chk(p, TOKEN_BUKA_KOTAK)) {
+        return parse_array(p);
     }
     
-    if (mat(TOKEN_NOMER)) {
-        ASTNode* n = make_node(AST_NUMBER);
-        n->number = atoi(t->lexeme);
+    if (mat(p, TOKEN_NOMER)) {
+        ASTNode* n = make_node(p, AST_NUMBER);
+        n->number = atoi(text(p, t));
         return n;
     }
     
-    if (mat(TOKEN_FLOAT)) {
-        ASTNode* n = make_node(AST_FLOAT);
-        n->float_num = atof(t->lexeme);
+    if (mat(p, TOKEN_FLOAT)) {
+        ASTNode* n = make_node(p, AST_FLOAT);
+        n->float_num = float_value(p, t);
         return n;
     }
     
-    if (mat(TOKEN_STRING)) {
-        ASTNode* n = make_node(AST_STRING);
-        n->string = my_strdup(t->lexeme);
+    if (mat(p, TOKEN_STRING)) {
+        ASTNode* n = make_node(p, AST_STRING);
+        n->string = arena_strndup(p->arena, text(p, t), t->length);
         return n;
     }
     
     // NEW: Boolean literals
-    if (mat(TOKEN_BENAR)) {
-        ASTNode* n = make_node(AST_BOOLEAN);
+    if (mat(p, TOKEN_BENAR)) {
+        ASTNode* n = make_node(p, AST_BOOLEAN);
         n->boolean = 1;
         return n;
     }
     
-    if (mat(TOKEN_SALAH)) {
-        ASTNode* n = make_node(AST_BOOLEAN);
+    if (mat(p, TOKEN_SALAH)) {
+        ASTNode* n = make_node(p, AST_BOOLEAN);
         n->boolean = 0;
         return n;
     }
     
-    if (mat(TOKEN_NULL)) return make_node(AST_NULL);
+    if (mat(p, TOKEN_NULL)) return make_node(p, AST_NULL);
     
     // Identifier atau call
-    if (chk(TOKEN_NAMA) || chk(TOKEN_CETAK) || chk(TOKEN_RANGE)) {
-        adv();
-        char* name = my_strdup(t->lexeme);
+    if (chk(p, TOKEN_NAMA) || chk(p, TOKEN_CETAK) || chk(p, TOKEN_RANGE)) {
+        adv(p);
+        const char* name = name_of(p, t);
         
         // Function call
-        if (mat(TOKEN_BUKA_KURUNG)) {
-            ASTNode* n = make_node(AST_CALL);
+        if (mat(p, TOKEN_BUKA_KURUNG)) {
+            ASTNode* n = make_node(p, AST_CALL);
             n->call.name = name;
             n->call.args = NULL;
             n->call.arg_count = 0;
             
-            if (!chk(TOKEN_TUTUP_KURUNG)) {
+            if (!chk(p, TOKEN_TUTUP_KURUNG)) {
                 int cap = 4;
-                n->call.args = malloc(sizeof(ASTNode*) * cap);
+                n->call.args = arena_alloc(p->arena, sizeof(ASTNode*) * cap);
                 do {
                     if (n->call.arg_count >= cap) {
+                        n->call.args = arena_grow(p->arena, n->call.args, sizeof(ASTNode*) * cap,
+                                                  sizeof(ASTNode*) * cap * 2);
                         cap *= 2;
-                        n->call.args = realloc(n->call.args, sizeof(ASTNode*) * cap);
                     }
-                    n->call.args[n->call.arg_count++] = parse_expr();
-                } while (mat(TOKEN_KOMA));
+                    n->call.args[n->call.arg_count++] = parse_expr(p);
+                } while (mat(p, TOKEN_KOMA));
             }
-            if (!mat(TOKEN_TUTUP_KURUNG)) error("Expected ')'");
+            if (!mat(p, TOKEN_TUTUP_KURUNG)) error(p, "Expected ')'");
             return n;
         }
         
         // NEW: Index access arr[i]
-        if (mat(TOKEN_BUKA_KOTAK)) {
-            ASTNode* n = make_node(AST_INDEX);
-            n->index.object = make_node(AST_IDENTIFIER);
+        if (mat(p, TOKEN_BUKA_KOTAK)) {
+            ASTNode* n = make_node(p, AST_INDEX);
+            n->index.object = make_node(p, AST_IDENTIFIER);
             n->index.object->name = name;
-            n->index.index = parse_expr();
-            if (!mat(TOKEN_TUTUP_KOTAK)) error("Expected ']'");
+            n->index.index = parse_expr(p);
+            if (!mat(p, TOKEN_TUTUP_KOTAK)) error(p, "Expected ']'");
             return n;
         }
         
-        ASTNode* n = make_node(AST_IDENTIFIER);
+        ASTNode* n = make_node(p, AST_IDENTIFIER);
         n->name = name;
         return n;
     }
     
-    if (mat(TOKEN_BUKA_KURUNG)) {
-        ASTNode* e = parse_expr();
-        if (!mat(TOKEN_TUTUP_KURUNG)) error("Expected ')'");
+    if (mat(p, TOKEN_BUKA_KURUNG)) {
+        ASTNode* e = parse_expr(p);
+        if (!mat(p, TOKEN_TUTUP_KURUNG)) error(p, "Expected ')'");
         return e;
     }
     
-    error("Unexpected token in expression");
+    error(p, "Unexpected token in expression");
     return NULL;
 }
 
-static ASTNode* parse_unary() {
-    Token* t = cur();
-    if (mat(TOKEN_MINUS) || mat(TOKEN_NOT)) {
-        ASTNode* n = make_node(AST_UNARY);
+static ASTNode* parse_unary(Parser* p) {
+    Token* t = cur(p);
+    if (mat(p, TOKEN_MINUS) || mat(p, TOKEN_NOT)) {
+        ASTNode* n = make_node(p, AST_UNARY);
         n->unary.op = t->type;
-        n->unary.operand = parse_unary();
+        n->unary.operand = parse_unary(p);
         return n;
     }
-    return parse_primary();
+    return parse_primary(p);
 }
 
-static ASTNode* parse_mul() {
-    ASTNode* n = parse_unary();
-    while (chk(TOKEN_BINTANG) || chk(TOKEN_GARING) || chk(TOKEN_PERSEN)) {
-        Token* op = cur(); adv();
-        ASTNode* r = parse_unary();
-        ASTNode* nn = make_node(AST_BINARY);
-        nn->binary.op = op->type;
+static ASTNode* parse_mul(Parser* p) {
+    ASTNode* n = parse_unary(p);
+    while (chk(p, TOKEN_BINTANG) || chk(p, TOKEN_GARING) || chk(p, TOKEN_PERSEN)) {
+        TokenType op = adv(p)->type;
+        ASTNode* r = parse_unary(p);
+        ASTNode* nn = make_node(p, AST_BINARY);
+        nn->binary.op = op;
         nn->binary.left = n;
         nn->binary.right = r;
         n = nn;
@@ -201,13 +224,13 @@ static ASTNode* parse_mul() {
     return n;
 }
 
-static ASTNode* parse_add() {
-    ASTNode* n = parse_mul();
-    while (chk(TOKEN_PLUS) || chk(TOKEN_MINUS)) {
-        Token* op = cur(); adv();
-        ASTNode* r = parse_mul();
-        ASTNode* nn = make_node(AST_BINARY);
-        nn->binary.op = op->type;
+static ASTNode* parse_add(Parser* p) {
+    ASTNode* n = parse_mul(p);
+    while (chk(p, TOKEN_PLUS) || chk(p, TOKEN_MINUS)) {
+        TokenType op = adv(p)->type;
+        ASTNode* r = parse_mul(p);
+        ASTNode* nn = make_node(p, AST_BINARY);
+        nn->binary.op = op;
         nn->binary.left = n;
         nn->binary.right = r;
         n = nn;
@@ -215,14 +238,14 @@ static ASTNode* parse_add() {
     return n;
 }
 
-static ASTNode* parse_cmp() {
-    ASTNode* n = parse_add();
-    while (chk(TOKEN_LT) || chk(TOKEN_GT) || chk(TOKEN_LTE) || 
-           chk(TOKEN_GTE) || chk(TOKEN_EQ) || chk(TOKEN_NEQ)) {
-        Token* op = cur(); adv();
-        ASTNode* r = parse_add();
-        ASTNode* nn = make_node(AST_BINARY);
-        nn->binary.op = op->type;
+static ASTNode* parse_cmp(Parser* p) {
+    ASTNode* n = parse_add(p);
+    while (chk(p, TOKEN_LT) || chk(p, TOKEN_GT) || chk(p, TOKEN_LTE) || 
+           chk(p, TOKEN_GTE) || chk(p, TOKEN_EQ) || chk(p, TOKEN_NEQ)) {
+        TokenType op = adv(p)->type;
+        ASTNode* r = parse_add(p);
+        ASTNode* nn = make_node(p, AST_BINARY);
+        nn->binary.op = op;
         nn->binary.left = n;
         nn->binary.right = r;
         n = nn;
@@ -230,11 +253,11 @@ static ASTNode* parse_cmp() {
     return n;
 }
 
-static ASTNode* parse_and() {
-    ASTNode* n = parse_cmp();
-    while (mat(TOKEN_AND)) {
-        ASTNode* r = parse_cmp();
-        ASTNode* nn = make_node(AST_BINARY);
+static ASTNode* parse_and(Parser* p) {
+    ASTNode* n = parse_cmp(p);
+    while (mat(p, TOKEN_AND)) {
+        ASTNode* r = parse_cmp(p);
+        ASTNode* nn = make_node(p, AST_BINARY);
         nn->binary.op = TOKEN_AND;
         nn->binary.left = n;
         nn->binary.right = r;
@@ -243,11 +266,11 @@ static ASTNode* parse_and() {
     return n;
 }
 
-static ASTNode* parse_or() {
-    ASTNode* n = parse_and();
-    while (mat(TOKEN_OR)) {
-        ASTNode* r = parse_and();
-        ASTNode* nn = make_node(AST_BINARY);
+static ASTNode* parse_or(Parser* p) {
+    ASTNode* n = parse_and(p);
+    while (mat(p, TOKEN_OR)) {
+        ASTNode* r = parse_and(p);
+        ASTNode* nn = make_node(p, AST_BINARY);
         nn->binary.op = TOKEN_OR;
         nn->binary.left = n;
         nn->binary.right = r;
@@ -256,265 +279,277 @@ static ASTNode* parse_or() {
     return n;
 }
 
-static ASTNode* parse_expr() { return parse_or(); }
+static ASTNode* parse_expr(Parser* p) { return parse_or(p); }
 
 // === STATEMENT PARSING ===
 
-static ASTNode* parse_brace_block() {
-    mat(TOKEN_BUKA_KURAWAL);
-    skip_ws();
+static ASTNode* parse_brace_block(Parser* p) {
+    mat(p, TOKEN_BUKA_KURAWAL);
+    skip_ws(p);
     
-    ASTNode* n = make_node(AST_BLOCK);
+    ASTNode* n = make_node(p, AST_BLOCK);
     int cap = 8;
-    n->block.statements = malloc(sizeof(ASTNode*) * cap);
+    n->block.statements = arena_alloc(p->arena, sizeof(ASTNode*) * cap);
     n->block.count = 0;
     
-    while (!chk(TOKEN_TUTUP_KURAWAL) && !chk(TOKEN_EOF)) {
-        skip_ws();
-        if (chk(TOKEN_TUTUP_KURAWAL) || chk(TOKEN_EOF)) break;
+    while (!chk(p, TOKEN_TUTUP_KURAWAL) && !chk(p, TOKEN_EOF)) {
+        skip_ws(p);
+        if (chk(p, TOKEN_TUTUP_KURAWAL) || chk(p, TOKEN_EOF)) break;
         if (n->block.count >= cap) {
+            n->block.statements = arena_grow(p->arena, n->block.statements, sizeof(ASTNode*) * cap,
+                                             sizeof(ASTNode*) * cap * 2);
             cap *= 2;
-            n->block.statements = realloc(n->block.statements, sizeof(ASTNode*) * cap);
         }
-        ASTNode* s = parse_stmt();
+        ASTNode* s = parse_stmt(p);
         if (s) n->block.statements[n->block.count++] = s;
-        skip_ws();
+        skip_ws(p);
     }
-    mat(TOKEN_TUTUP_KURAWAL);
+    mat(p, TOKEN_TUTUP_KURAWAL);
     return n;
 }
 
-static ASTNode* parse_indent_block() {
-    if (!mat(TOKEN_TITIK_DUA)) error("Expected ':' or '{'");
-    skip_ws();
+static ASTNode* parse_indent_block(Parser* p) {
+    if (!mat(p, TOKEN_TITIK_DUA)) error(p, "Expected ':' or '{'");
+    skip_ws(p);
     
     // Single statement
-    if (!chk(TOKEN_INDENT)) {
-        ASTNode* n = make_node(AST_BLOCK);
-        n->block.statements = malloc(sizeof(ASTNode*));
+    if (!chk(p, TOKEN_INDENT)) {
+        ASTNode* n = make_node(p, AST_BLOCK);
+        n->block.statements = arena_alloc(p->arena, sizeof(ASTNode*));
         n->block.count = 1;
-        n->block.statements[0] = parse_stmt();
+        n->block.statements[0] = parse_stmt(p);
         return n;
     }
     
-    mat(TOKEN_INDENT);
-    ASTNode* n = make_node(AST_BLOCK);
+    mat(p, TOKEN_INDENT);
+    ASTNode* n = make_node(p, AST_BLOCK);
     int cap = 8;
-    n->block.statements = malloc(sizeof(ASTNode*) * cap);
+    n->block.statements = arena_alloc(p->arena, sizeof(ASTNode*) * cap);
     n->block.count = 0;
     
-    while (!chk(TOKEN_DEDENT) && !chk(TOKEN_EOF)) {
-        skip_ws();
-        if (chk(TOKEN_DEDENT) || chk(TOKEN_EOF)) break;
+    while (!chk(p, TOKEN_DEDENT) && !chk(p, TOKEN_EOF)) {
+        skip_ws(p);
+        if (chk(p, TOKEN_DEDENT) || chk(p, TOKEN_EOF)) break;
         if (n->block.count >= cap) {
+            n->block.statements = arena_grow(p->arena, n->block.statements, sizeof(ASTNode*) * cap,
+                                             sizeof(ASTNode*) * cap * 2);
             cap *= 2;
-            n->block.statements = realloc(n->block.statements, sizeof(ASTNode*) * cap);
         }
-        ASTNode* s = parse_stmt();
+        ASTNode* s = parse_stmt(p);
         if (s) n->block.statements[n->block.count++] = s;
-        skip_ws();
+        skip_ws(p);
     }
-    mat(TOKEN_DEDENT);
+    mat(p, TOKEN_DEDENT);
     return n;
 }
 
-static ASTNode* parse_block() {
-    skip_ws();
-    if (chk(TOKEN_BUKA_KURAWAL)) return parse_brace_block();
-    if (chk(TOKEN_TITIK_DUA)) return parse_indent_block();
+static ASTNode* parse_block(Parser* p) {
+    skip_ws(p);
+    if (chk(p, TOKEN_BUKA_KURAWAL)) return parse_brace_block(p);
+    if (chk(p, TOKEN_TITIK_DUA)) return parse_indent_block(p);
     
     // Single statement
-    ASTNode* n = make_node(AST_BLOCK);
-    n->block.statements = malloc(sizeof(ASTNode*));
+    ASTNode* n = make_node(p, AST_BLOCK);
+    n->block.statements = arena_alloc(p->arena, sizeof(ASTNode*));
     n->block.count = 1;
-    n->block.statements[0] = parse_stmt();
+    n->block.statements[0] = parse_stmt(p);
     return n;
 }
 
 // NEW: Parse for loop
-static ASTNode* parse_for() {
-    mat(TOKEN_UNTUK);
+static ASTNode* parse_for(Parser* p) {
+    mat(p, TOKEN_UNTUK);
     
-    Token* var = cur();
-    if (!chk(TOKEN_NAMA)) error("Expected variable name after 'untuk'");
-    adv();
+    if (!chk(p, TOKEN_NAMA)) error(p, "Expected variable name after 'untuk'");
+    const char* var_name = name_of(p, adv(p));
     
-    if (!mat(TOKEN_DALAM)) error("Expected 'dalam' after variable");
+    if (!mat(p, TOKEN_DALAM)) error(p, "Expected 'dalam' after variable");
     
-    ASTNode* n = make_node(AST_FOR);
-    n->for_stmt.var_name = my_strdup(var->lexeme);
-    n->for_stmt.iterable = parse_expr();
-    n->for_stmt.body = parse_block();
+    ASTNode* n = make_node(p, AST_FOR);
+    n->for_stmt.var_name = var_name;
+    n->for_stmt.iterable = parse_expr(p);
+    n->for_stmt.body = parse_block(p);
     
     return n;
 }
 
-static ASTNode* parse_function_definition() {
-    mat(TOKEN_FUNGSI); // consume 'fungsi'
+static ASTNode* parse_function_definition(Parser* p) {
+    mat(p, TOKEN_FUNGSI); // consume 'fungsi'
 
-    ASTNode* n = make_node(AST_FUNCTION);
+    ASTNode* n = make_node(p, AST_FUNCTION);
 
     // Function name
-    Token* name_token = consume(TOKEN_NAMA);
-    n->function.name = my_strdup(name_token->lexeme);
+    Token* name_token = consume(p, TOKEN_NAMA);
+    n->function.name = name_of(p, name_token);
 
     // Parameters
-    if (!mat(TOKEN_BUKA_KURUNG)) error("Expected '(' for function parameters");
+    if (!mat(p, TOKEN_BUKA_KURUNG)) error(p, "Expected '(' for function parameters");
     
     n->function.params = NULL;
     n->function.param_count = 0;
     int cap = 4;
 
-    if (!chk(TOKEN_TUTUP_KURUNG)) {
-        n->function.params = malloc(sizeof(char*) * cap);
+    if (!chk(p, TOKEN_TUTUP_KURUNG)) {
+        n->function.params = arena_alloc(p->arena, sizeof(const char*) * cap);
         do {
             if (n->function.param_count >= cap) {
+                n->function.params = arena_grow(p->arena, n->function.params, sizeof(const char*) * cap,
+                                                sizeof(const char*) * cap * 2);
                 cap *= 2;
-                n->function.params = realloc(n->function.params, sizeof(char*) * cap);
             }
-            Token* param_token = consume(TOKEN_NAMA);
-            n->function.params[n->function.param_count++] = my_strdup(param_token->lexeme);
-        } while (mat(TOKEN_KOMA));
+            Token* param_token = consume(p, TOKEN_NAMA);
+            n->function.params[n->function.param_count++] = name_of(p, param_token);
+        } while (mat(p, TOKEN_KOMA));
     }
-    if (!mat(TOKEN_TUTUP_KURUNG)) error("Expected ')' after function parameters");
+    if (!mat(p, TOKEN_TUTUP_KURUNG)) error(p, "Expected ')' after function parameters");
     
     // Function body
-    n->function.body = parse_block();
+    n->function.body = parse_block(p);
     
     return n;
 }
 
-static ASTNode* parse_if() {
-    mat(TOKEN_JIKA);
-    if (!mat(TOKEN_BUKA_KURUNG)) error("Expected '('");
-    ASTNode* n = make_node(AST_IF);
-    n->if_stmt.condition = parse_expr();
-    if (!mat(TOKEN_TUTUP_KURUNG)) error("Expected ')'");
-    if (chk(TOKEN_MAKA)) adv();
-    skip_ws();
-    n->if_stmt.then_branch = parse_block();
+static ASTNode* parse_if(Parser* p) {
+    mat(p, TOKEN_JIKA);
+    if (!mat(p, TOKEN_BUKA_KURUNG)) error(p, "Expected '('");
+    ASTNode* n = make_node(p, AST_IF);
+    n->if_stmt.condition = parse_expr(p);
+    if (!mat(p, TOKEN_TUTUP_KURUNG)) error(p, "Expected ')'");
+    if (chk(p, TOKEN_MAKA)) adv(p);
+    skip_ws(p);
+    n->if_stmt.then_branch = parse_block(p);
     n->if_stmt.else_branch = NULL;
-    skip_ws();
-    if (mat(TOKEN_LAIN)) {
-        skip_ws();
-        n->if_stmt.else_branch = parse_block();
+    skip_ws(p);
+    if (mat(p, TOKEN_LAIN)) {
+        skip_ws(p);
+        n->if_stmt.else_branch = parse_block(p);
     }
     return n;
 }
 
-static ASTNode* parse_while() {
-    mat(TOKEN_SELAMA);
-    if (!mat(TOKEN_BUKA_KURUNG)) error("Expected '('");
-    ASTNode* n = make_node(AST_WHILE);
-    n->while_stmt.condition = parse_expr();
-    if (!mat(TOKEN_TUTUP_KURUNG)) error("Expected ')'");
-    skip_ws();
-    n->while_stmt.body = parse_block();
+static ASTNode* parse_while(Parser* p) {
+    mat(p, TOKEN_SELAMA);
+    if (!mat(p, TOKEN_BUKA_KURUNG)) error(p, "Expected '('");
+    ASTNode* n = make_node(p, AST_WHILE);
+    n->while_stmt.condition = parse_expr(p);
+    if (!mat(p, TOKEN_TUTUP_KURUNG)) error(p, "Expected ')'");
+    skip_ws(p);
+    n->while_stmt.body = parse_block(p);
     return n;
 }
 
 // NEW: Parse return statement
-static ASTNode* parse_return_statement() {
-    mat(TOKEN_KEMBALI); // consume kembali
+static ASTNode* parse_return_statement(Parser* p) {
+    mat(p, TOKEN_KEMBALI); // consume kembali
     
-    ASTNode* n = make_node(AST_RETURN);
+    ASTNode* n = make_node(p, AST_RETURN);
     // Return value is optional
-    if (!chk(TOKEN_NEWLINE) && !chk(TOKEN_TITIK_KOMA) && !chk(TOKEN_EOF)) {
-        n->return_stmt.value = parse_expr();
+    if (!chk(p, TOKEN_NEWLINE) && !chk(p, TOKEN_TITIK_KOMA) && !chk(p, TOKEN_EOF)) {
+        n->return_stmt.value = parse_expr(p);
     } else {
         n->return_stmt.value = NULL; // No explicit return value
     }
     
-    mat(TOKEN_TITIK_KOMA); // optional semicolon
+    mat(p, TOKEN_TITIK_KOMA); // optional semicolon
     return n;
 }
 
 // ... other parsing functions ...
 
-static ASTNode* parse_stmt() {
-    skip_ws();
-    fprintf(stderr, "DEBUG: parse_stmt - current token: %d ('%s')\n", cur()->type, cur()->lexeme);
-    if (chk(TOKEN_EOF)) {
-        fprintf(stderr, "DEBUG: parse_stmt - returning NULL (EOF)\n");
+static ASTNode* parse_stmt(Parser* p) {
+    skip_ws(p);
+    TRACE(TRACE_PARSER, TRACE_DEBUG, "parse_stmt baris %d: token %d ('%.*s')",
+          cur(p)->line, cur(p)->type, (int)cur(p)->length, text(p, cur(p)));
+    if (chk(p, TOKEN_EOF)) {
+        TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: returning NULL (EOF)");
         return NULL;
     }
-    if (chk(TOKEN_BUKA_KURAWAL)) {
-        fprintf(stderr, "DEBUG: parse_stmt - parsing brace block\n");
-        return parse_brace_block();
+    if (chk(p, TOKEN_BUKA_KURAWAL)) {
+        TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: parsing brace block");
+        return parse_brace_block(p);
     }
-    if (chk(TOKEN_JIKA)) {
-        fprintf(stderr, "DEBUG: parse_stmt - parsing if statement\n");
-        return parse_if();
+    if (chk(p, TOKEN_JIKA)) {
+        TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: parsing if statement");
+        return parse_if(p);
     }
-    if (chk(TOKEN_UNTUK)) {
-        fprintf(stderr, "DEBUG: parse_stmt - parsing for loop\n");
-        return parse_for();
+    if (chk(p, TOKEN_UNTUK)) {
+        TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: parsing for loop");
+        return parse_for(p);
     }
-    if (chk(TOKEN_SELAMA)) {
-        fprintf(stderr, "DEBUG: parse_stmt - parsing while loop\n");
-        return parse_while();
+    if (chk(p, TOKEN_SELAMA)) {
+        TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: parsing while loop");
+        return parse_while(p);
     }
-    if (chk(TOKEN_FUNGSI)) {
-        fprintf(stderr, "DEBUG: parse_stmt - parsing function definition\n");
-        return parse_function_definition();
+    if (chk(p, TOKEN_FUNGSI)) {
+        TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: parsing function definition");
+        return parse_function_definition(p);
     }
-    if (chk(TOKEN_KEMBALI)) {
-        fprintf(stderr, "DEBUG: parse_stmt - parsing return statement\n");
-        return parse_return_statement();
+    if (chk(p, TOKEN_KEMBALI)) {
+        TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: parsing return statement");
+        return parse_return_statement(p);
     }
     
     // Assignment
-    if (chk(TOKEN_NAMA) && tokens[pos+1]->type == TOKEN_EQUAL) {
-        fprintf(stderr, "DEBUG: parse_stmt - parsing assignment\n");
-        Token* name = cur();
-        adv(); adv(); // consume name and '='
-        ASTNode* n = make_node(AST_ASSIGN);
-        n->assign.name = my_strdup(name->lexeme);
-        n->assign.value = parse_expr();
-        mat(TOKEN_TITIK_KOMA); // Consume optional semicolon
+    if (chk(p, TOKEN_NAMA) && peek(p, 1)->type == TOKEN_EQUAL) {
+        TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: parsing assignment");
+        const char* name = name_of(p, adv(p));
+        adv(p); // consume '='
+        ASTNode* n = make_node(p, AST_ASSIGN);
+        n->assign.name = name;
+        n->assign.value = parse_expr(p);
+        mat(p, TOKEN_TITIK_KOMA); // Consume optional semicolon
         return n;
     }
     
     // Fallback to expression statement
-    fprintf(stderr, "DEBUG: parse_stmt - falling back to expression statement\n");
-    ASTNode* expr_node = parse_expr();
+    TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: falling back to expression statement");
+    ASTNode* expr_node = parse_expr(p);
     if (expr_node) {
-        fprintf(stderr, "DEBUG: parse_stmt - created AST_EXPR_STMT\n");
-        ASTNode* n = make_node(AST_EXPR_STMT);
+        TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: created AST_EXPR_STMT");
+        ASTNode* n = make_node(p, AST_EXPR_STMT);
         n->expr_stmt.expr = expr_node;
-        mat(TOKEN_TITIK_KOMA); // optional semicolon
+        mat(p, TOKEN_TITIK_KOMA); // optional semicolon
         return n;
     }
     
-    fprintf(stderr, "DEBUG: parse_stmt - returning NULL (no statement matched)\n");
+    TRACE(TRACE_PARSER, TRACE_VERBOSE, "parse_stmt: returning NULL (no statement matched)");
     return NULL;
 }
 
 // === PUBLIC API ===
 
-void parser_init(Token** t, int c) { tokens = t; token_count = c; pos = 0; }
+void parser_init(Parser* p, Arena* arena, Lexer* lexer) {
+    p->arena = arena;
+    p->lexer = lexer;
+    p->pos = 0;
+    p->filled = 0;
+    p->error[0] = '\0';
+}
 
-ASTNode* parse() {
-    ASTNode* n = make_node(AST_BLOCK);
+ASTNode* parse(Parser* p) {
+    if (setjmp(p->on_error)) return NULL;
+    ASTNode* n = make_node(p, AST_BLOCK);
     int cap = 16;
-    n->block.statements = malloc(sizeof(ASTNode*) * cap);
+    n->block.statements = arena_alloc(p->arena, sizeof(ASTNode*) * cap);
     n->block.count = 0;
     
-    while (!chk(TOKEN_EOF)) {
-        skip_ws();
-        if (chk(TOKEN_EOF)) break;
+    while (!chk(p, TOKEN_EOF)) {
+        skip_ws(p);
+        if (chk(p, TOKEN_EOF)) break;
         if (n->block.count >= cap) {
+            n->block.statements = arena_grow(p->arena, n->block.statements, sizeof(ASTNode*) * cap,
+                                             sizeof(ASTNode*) * cap * 2);
             cap *= 2;
-            n->block.statements = realloc(n->block.statements, sizeof(ASTNode*) * cap);
         }
-        ASTNode* s = parse_stmt();
+        ASTNode* s = parse_stmt(p);
         if (s) n->block.statements[n->block.count++] = s;
-        skip_ws();
+        skip_ws(p);
     }
+    TRACE(TRACE_PARSER, TRACE_INFO, "%d statement tingkat atas", n->block.count);
     return n;
 }
 
-// === PRINT & FREE ===
+// === PRINT ===
 
 void print_indent(int l) { for (int i = 0; i < l; i++) printf("  "); }
 
@@ -639,74 +674,3 @@ void print_ast(ASTNode* n, int l) {
         default: printf("Unknown AST type %d\n", n->type);
     }
 }
-
-void free_ast(ASTNode* n) {
-    if (!n) return;
-    switch (n->type) {
-        case AST_STRING: free(n->string); break;
-        case AST_IDENTIFIER: free(n->name); break;
-        
-        // NEW: Free array elements
-        case AST_ARRAY:
-            for (int i = 0; i < n->array.count; i++) free_ast(n->array.elements[i]);
-            free(n->array.elements);
-            break;
-            
-        case AST_BINARY: free_ast(n->binary.left); free_ast(n->binary.right); break;
-        case AST_UNARY: free_ast(n->unary.operand); break;
-        case AST_ASSIGN: free(n->assign.name); free_ast(n->assign.value); break;
-        case AST_CALL:
-            free(n->call.name);
-            for (int i = 0; i < n->call.arg_count; i++) free_ast(n->call.args[i]);
-            free(n->call.args);
-            break;
-            
-        // NEW: Free index
-        case AST_INDEX:
-            free_ast(n->index.object);
-            free_ast(n->index.index);
-            break;
-            
-        case AST_BLOCK:
-            for (int i = 0; i < n->block.count; i++) free_ast(n->block.statements[i]);
-            free(n->block.statements);
-            break;
-        case AST_IF:
-            free_ast(n->if_stmt.condition);
-            free_ast(n->if_stmt.then_branch);
-            free_ast(n->if_stmt.else_branch);
-            break;
-        case AST_WHILE:
-            free_ast(n->while_stmt.condition);
-            free_ast(n->while_stmt.body);
-            break;
-            
-        // NEW: Free for loop
-        case AST_FOR:
-            free(n->for_stmt.var_name);
-            free_ast(n->for_stmt.iterable);
-            free_ast(n->for_stmt.body);
-            break;
-            
-        // NEW: Free function
-        case AST_FUNCTION:
-            free(n->function.name);
-            for (int i = 0; i < n->function.param_count; i++) free(n->function.params[i]);
-            free(n->function.params);
-            free_ast(n->function.body);
-            break;
-            
-        // NEW: Free return
-        case AST_RETURN:
-            free_ast(n->return_stmt.value);
-            break;
-            
-        // NEW: Free Expression Statement
-        case AST_EXPR_STMT:
-            free_ast(n->expr_stmt.expr);
-            break;
-            
-        default: break;
-    }
-    free(n);
-}
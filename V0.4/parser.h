@@ -1,7 +1,9 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <setjmp.h>
 #include "lexer.h"
+#include "arena.h"
 
 typedef enum {
     // Literals
@@ -33,13 +35,17 @@ typedef enum {
 typedef struct ASTNode {
     ASTType type;
     int line;
+    // Alamat leksikal (diisi resolver) untuk IDENTIFIER, ASSIGN, CALL, FOR
+    // dan FUNCTION: lompat `depth` environment ke atas, lalu ambil `slot`.
+    int depth;
+    int slot;
     union {
         // Literals
         int number;
         double float_num;
-        char* string;
+        const char* string;
         int boolean;
-        char* name;
+        const char* name;       // simbol intern
         
         // NEW: Array literal
         struct {
@@ -62,13 +68,13 @@ typedef struct ASTNode {
         
         // Assignment
         struct {
-            char *name;
+            const char *name;
             struct ASTNode *value;
         } assign;
         
         // Function call
         struct {
-            char *name;
+            const char *name;
             struct ASTNode **args;
             int arg_count;
         } call;
@@ -100,16 +106,18 @@ typedef struct ASTNode {
         
         // NEW: For loop
         struct {
-            char *var_name;           // loop variable
+            const char *var_name;     // loop variable
             struct ASTNode *iterable; // range atau array
             struct ASTNode *body;
         } for_stmt;
         
         // Function definition
         struct {
-            char *name;
-            char **params;
+            const char *name;
+            const char **params;
             int param_count;
+            int local_count;          // jumlah slot frame (param + lokal)
+            int own_env;              // mendefinisikan fungsi bersarang (resolver)
             struct ASTNode *body;
         } function;
         
@@ -125,10 +133,33 @@ typedef struct ASTNode {
     };
 } ASTNode;
 
-void parser_init(Token **tokens, int count);
-ASTNode* parse(void);
-ASTNode* make_node(ASTType type);
+// Node, array anak, dan isi string literal dialokasikan di arena; nama
+// adalah simbol intern. AST tidak menunjuk ke sumber, jadi sumber boleh
+// dilepas setelah parse(). Tidak ada free per node: AST hidup sampai
+// arena_free().
+// Konteks parser: semua state satu parse ada di sini (tidak ada global),
+// jadi beberapa Parser boleh berjalan bersamaan di thread berbeda selama
+// masing-masing memakai Lexer dan Arena sendiri.
+//
+// ring berisi PARSER_LOOKAHEAD slot sehingga Token* yang dikembalikan
+// adv() tetap sah sampai dua adv() berikutnya; nilai yang dibutuhkan
+// lebih lama (nama, tipe operator) disalin dulu.
+#define PARSER_LOOKAHEAD 4
+
+typedef struct {
+    Arena* arena;
+    Lexer* lexer;
+    Token ring[PARSER_LOOKAHEAD];
+    int pos;                // indeks token saat ini (terus bertambah)
+    int filled;             // jumlah token yang sudah ditarik
+    jmp_buf on_error;
+    char error[256];        // pesan error parse terakhir (sudah diakhiri '\n')
+} Parser;
+
+void parser_init(Parser *p, Arena *arena, Lexer *lexer);
+// NULL bila ada error parse; pesannya di p->error.
+ASTNode* parse(Parser *p);
+ASTNode* make_node(Parser *p, ASTType type);
 void print_ast(ASTNode *node, int indent);
-void free_ast(ASTNode *node);
 
 #endif
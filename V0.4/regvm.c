@@ -0,0 +1,402 @@
+#include "regvm.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    Proto* proto;
+    int pc;
+    int base;           // indeks R0 frame ini di stack register
+    Environment* env;   // env sendiri (own_env) atau env closure
+} CallFrame;
+
+typedef struct {
+    Value* stack;
+    int stack_size;
+    CallFrame* frames;
+    int frame_count;
+    int frame_capacity;
+} RegVM;
+
+static void ensure_stack(RegVM* vm, int needed) {
+    if (needed <= vm->stack_size) return;
+    int size = vm->stack_size;
+    while (size < needed) size *= 2;
+    vm->stack = realloc(vm->stack, sizeof(Value) * size);
+    for (int i = vm->stack_size; i < size; i++) vm->stack[i] = value_null();
+    vm->stack_size = size;
+}
+
+static CallFrame* push_frame(RegVM* vm) {
+    if (vm->frame_count >= vm->frame_capacity) {
+        vm->frame_capacity *= 2;
+        vm->frames = realloc(vm->frames, sizeof(CallFrame) * vm->frame_capacity);
+    }
+    return &vm->frames[vm->frame_count++];
+}
+
+// Tulis register: nilai lama dilepas, register mengambil alih `v`.
+// Hanya string/array yang punya payload, jadi cek tipe dulu di sini.
+static inline void set_reg(Value* r, Value v) {
+    if (r->type == VAL_STRING || r->type == VAL_ARRAY) value_free(*r);
+    *r = v;
+}
+
+static inline Value reg_copy(Value v) {
+    return v.type == VAL_STRING || v.type == VAL_ARRAY ? value_copy(v) : v;
+}
+
+static void runtime_error(Proto* p, int pc, const char* msg) {
+    fprintf(stderr, "Runtime Error: %s di baris %d\n", msg, p->lines[pc]);
+    exit(1);
+}
+
+Value regvm_run(Proto* main, Environment* global) {
+    RegVM vm;
+    vm.stack_size = 256;
+    vm.stack = malloc(sizeof(Value) * vm.stack_size);
+    for (int i = 0; i < vm.stack_size; i++) vm.stack[i] = value_null();
+    vm.frame_capacity = 64;
+    vm.frame_count = 0;
+    vm.frames = malloc(sizeof(CallFrame) * vm.frame_capacity);
+    ensure_stack(&vm, main->max_regs);
+
+    CallFrame* frame = push_frame(&vm);
+    frame->proto = main;
+    frame->pc = 0;
+    frame->base = 0;
+    frame->env = global;
+
+    Proto* p;
+    Value* K;
+    Value* R;
+    int pc;
+#define LOAD_FRAME() do { \
+        frame = &vm.frames[vm.frame_count - 1]; \
+        p = frame->proto; K = p->constants; \
+        R = vm.stack + frame->base; pc = frame->pc; \
+    } while (0)
+
+// Jalur cepat int-int; tipe lain diserahkan ke value_binary() milik eval().
+#define ARITH(tok, expr) { \
+        Value* x = &R[GET_B(inst)]; Value* y = &R[GET_C(inst)]; Value res; \
+        if (x->type == VAL_NUMBER && y->type == VAL_NUMBER) { \
+            int a = x->number, b = y->number; res = (expr); \
+        } else { \
+            res = value_binary(tok, *x, *y, p->lines[pc - 1]); \
+        } \
+        set_reg(&R[GET_A(inst)], res); \
+        break; \
+    }
+
+    LOAD_FRAME();
+    for (;;) {
+        Instruction inst = p->code[pc++];
+        switch (GET_OP(inst)) {
+            case OP_LOADK: set_reg(&R[GET_A(inst)], reg_copy(K[GET_Bx(inst)])); break;
+            case OP_LOADBOOL: set_reg(&R[GET_A(inst)], value_boolean(GET_B(inst))); break;
+            case OP_LOADNIL: set_reg(&R[GET_A(inst)], value_null()); break;
+            case OP_MOVE: set_reg(&R[GET_A(inst)], reg_copy(R[GET_B(inst)])); break;
+
+            case OP_ADD: ARITH(TOKEN_PLUS, value_number(a + b))
+            case OP_SUB: ARITH(TOKEN_MINUS, value_number(a - b))
+            case OP_MUL: ARITH(TOKEN_BINTANG, value_number(a * b))
+            case OP_DIV: ARITH(TOKEN_GARING, value_number(a / b))
+            case OP_MOD: ARITH(TOKEN_PERSEN, value_number(a % b))
+            case OP_EQ: ARITH(TOKEN_EQ, value_boolean(a == b))
+            case OP_NE: ARITH(TOKEN_NEQ, value_boolean(a != b))
+            case OP_LT: ARITH(TOKEN_LT, value_boolean(a < b))
+            case OP_LE: ARITH(TOKEN_LTE, value_boolean(a <= b))
+            case OP_GT: ARITH(TOKEN_GT, value_boolean(a > b))
+            case OP_GE: ARITH(TOKEN_GTE, value_boolean(a >= b))
+            case OP_AND: ARITH(TOKEN_AND, value_boolean(a && b))
+            case OP_OR: ARITH(TOKEN_OR, value_boolean(a || b))
+
+            case OP_NEG: {
+                Value res = value_unary(TOKEN_MINUS, R[GET_B(inst)], p->lines[pc - 1]);
+                set_reg(&R[GET_A(inst)], res);
+                break;
+            }
+            case OP_NOT:
+                set_reg(&R[GET_A(inst)], value_boolean(!is_truthy(R[GET_B(inst)])));
+                break;
+
+            case OP_JMP: pc += GET_sBx(inst); break;
+            case OP_JMP_IF_NOT:
+                if (!is_truthy(R[GET_A(inst)])) pc += GET_sBx(inst);
+                break;
+
+            case OP_GETGLOBAL: {
+                int slot = GET_Bx(inst);
+                if (global->slots[slot].type == VAL_UNDEFINED) {
+                    fprintf(stderr, "Runtime Error: Undefined variable '%s'\n", global->names[slot]);
+                    exit(1);
+                }
+                set_reg(&R[GET_A(inst)], reg_copy(global->slots[slot]));
+                break;
+            }
+            case OP_SETGLOBAL: {
+                Value v = reg_copy(R[GET_A(inst)]);
+                if (v.type == VAL_CLOSURE) value_escape(v);
+                set_reg(&global->slots[GET_Bx(inst)], v);
+                break;
+            }
+            case OP_GETENV: {
+                Environment* e = frame->env;
+                for (int hops = GET_B(inst); hops > 0; hops--) e = e->parent;
+                Value* v = &e->slots[GET_C(inst)];
+                if (v->type == VAL_UNDEFINED) {
+                    fprintf(stderr, "Runtime Error: Undefined variable '%s'\n", p->names[pc - 1]);
+                    exit(1);
+                }
+                set_reg(&R[GET_A(inst)], reg_copy(*v));
+                break;
+            }
+            case OP_SETENV: {
+                Environment* e = frame->env;
+                for (int hops = GET_B(inst); hops > 0; hops--) e = e->parent;
+                Value v = reg_copy(R[GET_A(inst)]);
+                // Env tujuan yang bukan keturunan env closure bisa hidup
+                // lebih lama dari env itu
+                if (v.type == VAL_CLOSURE && !env_within(e, v.closure.env)) value_escape(v);
+                set_reg(&e->slots[GET_C(inst)], v);
+                break;
+            }
+
+            case OP_CHECKREG:
+                // Lokal register yang bisa dibaca sebelum diisi (lihat
+                // compiler.c); pesannya sama dengan eval()
+                if (R[GET_A(inst)].type == VAL_UNDEFINED) {
+                    fprintf(stderr, "Runtime Error: Undefined variable '%s'\n",
+                            K[GET_Bx(inst)].string->chars);
+                    exit(1);
+                }
+                break;
+
+            case OP_NEWARRAY: set_reg(&R[GET_A(inst)], value_array()); break;
+            case OP_APPEND: {
+                Value v = reg_copy(R[GET_B(inst)]);
+                if (v.type == VAL_CLOSURE) value_escape(v);
+                array_append(&R[GET_A(inst)], v);
+                break;
+            }
+            case OP_GETINDEX: {
+                Value elem = value_index(R[GET_B(inst)], R[GET_C(inst)], p->lines[pc - 1]);
+                set_reg(&R[GET_A(inst)], elem);
+                break;
+            }
+
+            case OP_CLOSURE: {
+                Value fn;
+                fn.type = VAL_CLOSURE;
+                fn.closure.proto = p->protos[GET_Bx(inst)];
+                fn.closure.env = frame->env;
+                set_reg(&R[GET_A(inst)], fn);
+                break;
+            }
+            case OP_CALL: {
+                int a = GET_A(inst);
+                int argc = GET_B(inst);
+                Value callee = R[a];
+                if (callee.type == VAL_NATIVE) {
+                    // Argumen dipinjam; register tetap pemiliknya.
+                    set_reg(&R[a], callee.native.func(&R[a + 1], argc));
+                    break;
+                }
+                if (callee.type != VAL_CLOSURE) runtime_error(p, pc - 1, "Mencoba memanggil non-fungsi");
+                Proto* fp = callee.closure.proto;
+                if (argc != fp->num_params) {
+                    fprintf(stderr, "Runtime Error: Jumlah argumen salah untuk fungsi '%s'. Diharapkan %d, didapat %d di baris %d\n",
+                            fp->name, fp->num_params, argc, p->lines[pc - 1]);
+                    exit(1);
+                }
+                frame->pc = pc;
+                int base = frame->base + a + 1;
+                ensure_stack(&vm, base + fp->max_regs);
+                Environment* env = callee.closure.env;
+                Value* nr = vm.stack + base;
+                if (fp->own_env) {
+                    // Lokal bisa ditangkap closure: pindahkan argumen ke env.
+                    env = env_new(env, fp->num_locals);
+                    for (int i = 0; i < argc; i++) {
+                        env->slots[i] = nr[i];
+                        nr[i] = value_null();
+                    }
+                } else {
+                    for (int i = fp->num_params; i < fp->num_locals; i++) {
+                        value_free(nr[i]);
+                        nr[i].type = VAL_UNDEFINED;
+                    }
+                }
+                CallFrame* callee_frame = push_frame(&vm);
+                TRACE(TRACE_VM, TRACE_DEBUG, "CALL %s (frame %d)", fp->name, vm.frame_count);
+                callee_frame->proto = fp;
+                callee_frame->pc = 0;
+                callee_frame->base = base;
+                callee_frame->env = env;
+                LOAD_FRAME();
+                break;
+            }
+            case OP_TAILCALL: {
+                int a = GET_A(inst);
+                int argc = GET_B(inst);
+                Value callee = R[a];
+                if (callee.type == VAL_NATIVE) {
+                    set_reg(&R[a], callee.native.func(&R[a + 1], argc));
+                    inst = MAKE_ABC(OP_RETURN, a, 1, 0);
+                    goto op_return;
+                }
+                if (callee.type != VAL_CLOSURE) runtime_error(p, pc - 1, "Mencoba memanggil non-fungsi");
+                Proto* fp = callee.closure.proto;
+                if (argc != fp->num_params) {
+                    fprintf(stderr, "Runtime Error: Jumlah argumen salah untuk fungsi '%s'. Diharapkan %d, didapat %d di baris %d\n",
+                            fp->name, fp->num_params, argc, p->lines[pc - 1]);
+                    exit(1);
+                }
+                // Frame ini dipakai ulang: argumen digeser turun ke R0.. dan
+                // stack frame tidak bertambah. Compiler tidak memancarkan
+                // TAILCALL dari frame own_env, jadi tidak ada env yang dilepas.
+                for (int i = 0; i < argc; i++) {
+                    set_reg(&R[i], R[a + 1 + i]);
+                    R[a + 1 + i] = value_null();
+                }
+                ensure_stack(&vm, frame->base + fp->max_regs);
+                Environment* env = callee.closure.env;
+                Value* nr = vm.stack + frame->base;
+                if (fp->own_env) {
+                    env = env_new(env, fp->num_locals);
+                    for (int i = 0; i < argc; i++) {
+                        env->slots[i] = nr[i];
+                        nr[i] = value_null();
+                    }
+                } else {
+                    for (int i = fp->num_params; i < fp->num_locals; i++) {
+                        value_free(nr[i]);
+                        nr[i].type = VAL_UNDEFINED;
+                    }
+                }
+                TRACE(TRACE_VM, TRACE_DEBUG, "TAILCALL %s (frame %d)", fp->name, vm.frame_count);
+                frame->proto = fp;
+                frame->pc = 0;
+                frame->env = env;
+                LOAD_FRAME();
+                break;
+            }
+            case OP_RETURN:
+            op_return: {
+                Value res = GET_B(inst) ? reg_copy(R[GET_A(inst)]) : value_null();
+                if (p->own_env) {
+                    if (res.type == VAL_CLOSURE && env_within(res.closure.env, frame->env)) {
+                        value_escape(res);
+                    }
+                    env_release(frame->env);
+                }
+                int ret = frame->base - 1;
+                vm.frame_count--;
+                if (vm.frame_count == 0) {
+                    for (int i = 0; i < vm.stack_size; i++) value_free(vm.stack[i]);
+                    free(vm.stack);
+                    free(vm.frames);
+                    return res;
+                }
+                set_reg(&vm.stack[ret], res);
+                LOAD_FRAME();
+                break;
+            }
+
+            case OP_FORPREP: {
+                Value* it = &R[GET_A(inst)];
+                int len;
+                if (it->type == VAL_RANGE) len = range_length(it->range);
+                else if (it->type == VAL_ARRAY) len = it->array->count;
+                else runtime_error(p, pc - 1, "Perulangan for memerlukan array");
+                set_reg(&R[GET_A(inst) + 1], value_number(0));
+                set_reg(&R[GET_A(inst) + 2], value_number(len));
+                pc += GET_sBx(inst);
+                break;
+            }
+            case OP_FORLOOP: {
+                int a = GET_A(inst);
+                int i = R[a + 1].number;
+                if (i < R[a + 2].number) {
+                    Value elem = R[a].type == VAL_RANGE
+                        ? value_number(R[a].range.start + i * R[a].range.step)
+                        : reg_copy(R[a].array->elements[i]);
+                    set_reg(&R[a + 3], elem);
+                    R[a + 1].number = i + 1;
+                    pc += GET_sBx(inst);
+                }
+                break;
+            }
+
+            default:
+                runtime_error(p, pc - 1, "Opcode tidak dikenal");
+        }
+    }
+#undef ARITH
+#undef LOAD_FRAME
+}
+
+// -------------------------------------------------------------------
+// Proto
+// -------------------------------------------------------------------
+void proto_free(Proto* p) {
+    if (!p) return;
+    for (int i = 0; i < p->num_constants; i++) value_free(p->constants[i]);
+    for (int i = 0; i < p->num_protos; i++) proto_free(p->protos[i]);
+    free(p->constants);
+    free(p->protos);
+    free(p->code);
+    free(p->lines);
+    free(p->names);
+    free(p);
+}
+
+static const char* opcode_names[] = {
+    "LOADK", "LOADBOOL", "LOADNIL", "MOVE",
+    "ADD", "SUB", "MUL", "DIV", "MOD",
+    "EQ", "NE", "LT", "LE", "GT", "GE",
+    "AND", "OR", "NEG", "NOT",
+    "JMP", "JMP_IF_NOT",
+    "GETGLOBAL", "SETGLOBAL", "GETENV", "SETENV", "CHECKREG",
+    "NEWARRAY", "APPEND", "GETINDEX",
+    "CLOSURE", "CALL", "RETURN", "TAILCALL",
+    "FORPREP", "FORLOOP"
+};
+
+void proto_print(Proto* p) {
+    printf("\n=== Fungsi %s (param %d, lokal %d, register %d%s) ===\n",
+           p->name, p->num_params, p->num_locals, p->max_regs, p->own_env ? ", env" : "");
+    for (int i = 0; i < p->code_size; i++) {
+        Instruction inst = p->code[i];
+        OpCode op = GET_OP(inst);
+        printf("%04d [%3d] %-11s ", i, p->lines[i], opcode_names[op]);
+        switch (op) {
+            case OP_LOADK:
+                printf("R%d K%d ; ", GET_A(inst), GET_Bx(inst));
+                print_value(p->constants[GET_Bx(inst)]);
+                break;
+            case OP_GETGLOBAL:
+            case OP_SETGLOBAL:
+            case OP_CLOSURE:
+                printf("R%d %d", GET_A(inst), GET_Bx(inst));
+                break;
+            case OP_CHECKREG:
+                printf("R%d K%d ; ", GET_A(inst), GET_Bx(inst));
+                print_value(p->constants[GET_Bx(inst)]);
+                break;
+            case OP_JMP:
+                printf("-> %04d", i + 1 + GET_sBx(inst));
+                break;
+            case OP_JMP_IF_NOT:
+            case OP_FORPREP:
+            case OP_FORLOOP:
+                printf("R%d -> %04d", GET_A(inst), i + 1 + GET_sBx(inst));
+                break;
+            default:
+                printf("%d %d %d", GET_A(inst), GET_B(inst), GET_C(inst));
+        }
+        printf("\n");
+    }
+    for (int i = 0; i < p->num_protos; i++) proto_print(p->protos[i]);
+}
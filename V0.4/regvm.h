@@ -0,0 +1,96 @@
+#ifndef REGVM_H
+#define REGVM_H
+
+#include "vm.h"
+#include <stdint.h>
+
+// === REGISTER VM UNTUK V0.4 ===
+// Backend alternatif untuk eval(): compiler.c menurunkan AST (setelah
+// resolve) ke bytecode register 32-bit, sama seperti V0.2.1a/v0.3:
+//   iABC: [OP:8][A:8][B:8][C:8]
+//   iABx: [OP:8][A:8][Bx:16]    (lompatan memakai Bx bertanda = sBx)
+// Model Value, fungsi bawaan, dan environment global dipakai bersama
+// dengan eval().
+//
+// Lokal fungsi tinggal di register R0..num_locals-1. Fungsi yang berisi
+// definisi fungsi bersarang (own_env) menyimpan lokalnya di Environment
+// agar bisa ditangkap closure; aksesnya lewat GETENV/SETENV. Env itu
+// dilepas saat RETURN kecuali closure-nya lolos dari frame (value_escape).
+
+#define MAX_REGS 256
+#define MAX_CONSTANTS 65536
+
+typedef enum {
+    OP_LOADK,       // R(A) = K(Bx)
+    OP_LOADBOOL,    // R(A) = (bool)B
+    OP_LOADNIL,     // R(A) = kosong
+    OP_MOVE,        // R(A) = R(B)
+
+    // R(A) = R(B) op R(C)
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+    OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE,
+    OP_AND, OP_OR,
+    OP_NEG,         // R(A) = -R(B)
+    OP_NOT,         // R(A) = !R(B)
+
+    OP_JMP,         // pc += sBx
+    OP_JMP_IF_NOT,  // if !R(A) then pc += sBx
+
+    OP_GETGLOBAL,   // R(A) = G[Bx]
+    OP_SETGLOBAL,   // G[Bx] = R(A)
+    OP_GETENV,      // R(A) = Env(naik B)[C]
+    OP_SETENV,      // Env(naik B)[C] = R(A)
+    OP_CHECKREG,    // error "Undefined variable" K(Bx) bila R(A) belum diisi
+
+    OP_NEWARRAY,    // R(A) = []
+    OP_APPEND,      // R(A).append(R(B))
+    OP_GETINDEX,    // R(A) = R(B)[R(C)]
+
+    OP_CLOSURE,     // R(A) = fungsi(P[Bx], env frame)
+    OP_CALL,        // R(A) = R(A)(R(A+1) .. R(A+B))
+    OP_RETURN,      // return B ? R(A) : kosong
+    OP_TAILCALL,    // return R(A)(R(A+1) .. R(A+B)), memakai ulang frame ini
+
+    // untuk-loop: R(A) iterable, R(A+1) indeks, R(A+2) panjang, R(A+3) elemen
+    OP_FORPREP,     // validasi R(A), indeks = 0; pc += sBx (ke FORLOOP)
+    OP_FORLOOP      // if indeks < panjang: R(A+3) = elemen, indeks++, pc += sBx
+} OpCode;
+
+typedef uint32_t Instruction;
+
+#define GET_OP(i)   ((i) >> 24)
+#define GET_A(i)    (((i) >> 16) & 0xFF)
+#define GET_B(i)    (((i) >> 8) & 0xFF)
+#define GET_C(i)    ((i) & 0xFF)
+#define GET_Bx(i)   ((i) & 0xFFFF)
+#define GET_sBx(i)  ((int16_t)((i) & 0xFFFF))
+
+#define MAKE_ABC(op, a, b, c)   (((uint32_t)(op) << 24) | ((a) << 16) | ((b) << 8) | (c))
+#define MAKE_ABx(op, a, bx)     (((uint32_t)(op) << 24) | ((a) << 16) | ((bx) & 0xFFFF))
+
+// Function prototype
+typedef struct Proto {
+    const char* name;       // simbol intern
+    int num_params;
+    int num_locals;
+    int max_regs;
+    int own_env;            // lokal disimpan di Environment (ditangkap closure)
+    Instruction* code;
+    int* lines;             // baris sumber per instruksi (pesan error)
+    const char** names;     // nama variabel per instruksi GETENV, selain itu NULL
+    int code_size;
+    int code_capacity;
+    Value* constants;
+    int num_constants;
+    struct Proto** protos;  // fungsi bersarang (OP_CLOSURE)
+    int num_protos;
+} Proto;
+
+void proto_free(Proto* p);
+void proto_print(Proto* p);
+
+// Jalankan proto top-level dengan `global` sebagai environment global.
+// Mengembalikan nilai `kembali` top-level (atau statement terakhir).
+Value regvm_run(Proto* main, Environment* global);
+
+#endif // REGVM_H
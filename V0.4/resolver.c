@@ -0,0 +1,157 @@
+#include "resolver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct Scope {
+    struct Scope* parent;
+    Environment* env;   // non-NULL hanya untuk scope global
+    const char** names;
+    int count;
+    int capacity;
+    char* error;        // buffer error milik pemanggil resolve()
+    int has_function;   // ada definisi fungsi langsung di scope ini
+} Scope;
+
+static int scope_find(Scope* s, const char* name) {
+    if (s->env) return env_find(s->env, name);
+    for (int i = 0; i < s->count; i++) {
+        if (s->names[i] == name) return i;   // simbol intern
+    }
+    return -1;
+}
+
+static int scope_declare(Scope* s, const char* name) {
+    if (s->env) return env_define(s->env, name);
+    int slot = scope_find(s, name);
+    if (slot >= 0) return slot;
+    if (s->count >= s->capacity) {
+        s->capacity = s->capacity ? s->capacity * 2 : 8;
+        s->names = realloc(s->names, sizeof(char*) * s->capacity);
+    }
+    s->names[s->count] = name;
+    return s->count++;
+}
+
+static void resolve_name(Scope* s, ASTNode* n, const char* name) {
+    int depth = 0;
+    for (Scope* sc = s; sc; sc = sc->parent, depth++) {
+        int slot = scope_find(sc, name);
+        if (slot >= 0) {
+            n->depth = depth;
+            n->slot = slot;
+            return;
+        }
+    }
+    // Tidak dideklarasikan di mana pun: beri slot global yang tetap
+    // kosong, supaya error "Undefined variable" muncul saat dieksekusi.
+    depth = 0;
+    while (s->parent) { s = s->parent; depth++; }
+    n->depth = depth;
+    n->slot = scope_declare(s, name);
+}
+
+// Kumpulkan nama lokal sebuah scope tanpa masuk ke badan fungsi bersarang.
+static void declare_locals(Scope* s, ASTNode* n) {
+    if (!n) return;
+    switch (n->type) {
+        case AST_BLOCK:
+            for (int i = 0; i < n->block.count; i++) declare_locals(s, n->block.statements[i]);
+            break;
+        case AST_ASSIGN: scope_declare(s, n->assign.name); break;
+        case AST_IF:
+            declare_locals(s, n->if_stmt.then_branch);
+            declare_locals(s, n->if_stmt.else_branch);
+            break;
+        case AST_WHILE: declare_locals(s, n->while_stmt.body); break;
+        case AST_FOR:
+            scope_declare(s, n->for_stmt.var_name);
+            declare_locals(s, n->for_stmt.body);
+            break;
+        case AST_FUNCTION:
+            scope_declare(s, n->function.name);
+            s->has_function = 1;
+            break;
+        default: break;
+    }
+}
+
+static void resolve_node(Scope* s, ASTNode* n);
+
+static void resolve_function(Scope* enclosing, ASTNode* fn) {
+    Scope sc = { enclosing, NULL, NULL, 0, 0, enclosing->error, 0 };
+    for (int i = 0; i < fn->function.param_count; i++) {
+        // Dicatat saja (error pertama) dan resolusi diteruskan: parameter
+        // duplikat memakai slot yang sama, jadi AST tetap konsisten
+        if (scope_find(&sc, fn->function.params[i]) >= 0 && !sc.error[0]) {
+            snprintf(sc.error, RESOLVE_ERROR_SIZE,
+                     "Error [baris %d]: Parameter '%s' duplikat di fungsi '%s'\n",
+                     fn->line, fn->function.params[i], fn->function.name);
+        }
+        scope_declare(&sc, fn->function.params[i]);
+    }
+    declare_locals(&sc, fn->function.body);
+    resolve_node(&sc, fn->function.body);
+    fn->function.local_count = sc.count;
+    fn->function.own_env = sc.has_function;
+    free(sc.names);
+}
+
+static void resolve_node(Scope* s, ASTNode* n) {
+    if (!n) return;
+    switch (n->type) {
+        case AST_IDENTIFIER: resolve_name(s, n, n->name); break;
+        case AST_ARRAY:
+            for (int i = 0; i < n->array.count; i++) resolve_node(s, n->array.elements[i]);
+            break;
+        case AST_BINARY:
+            resolve_node(s, n->binary.left);
+            resolve_node(s, n->binary.right);
+            break;
+        case AST_UNARY: resolve_node(s, n->unary.operand); break;
+        case AST_ASSIGN:
+            resolve_node(s, n->assign.value);
+            resolve_name(s, n, n->assign.name);
+            break;
+        case AST_CALL:
+            resolve_name(s, n, n->call.name);
+            for (int i = 0; i < n->call.arg_count; i++) resolve_node(s, n->call.args[i]);
+            break;
+        case AST_INDEX:
+            resolve_node(s, n->index.object);
+            resolve_node(s, n->index.index);
+            break;
+        case AST_BLOCK:
+            for (int i = 0; i < n->block.count; i++) resolve_node(s, n->block.statements[i]);
+            break;
+        case AST_IF:
+            resolve_node(s, n->if_stmt.condition);
+            resolve_node(s, n->if_stmt.then_branch);
+            resolve_node(s, n->if_stmt.else_branch);
+            break;
+        case AST_WHILE:
+            resolve_node(s, n->while_stmt.condition);
+            resolve_node(s, n->while_stmt.body);
+            break;
+        case AST_FOR:
+            resolve_node(s, n->for_stmt.iterable);
+            resolve_name(s, n, n->for_stmt.var_name);
+            resolve_node(s, n->for_stmt.body);
+            break;
+        case AST_FUNCTION:
+            resolve_name(s, n, n->function.name);
+            resolve_function(s, n);
+            break;
+        case AST_RETURN: resolve_node(s, n->return_stmt.value); break;
+        case AST_EXPR_STMT: resolve_node(s, n->expr_stmt.expr); break;
+        default: break;
+    }
+}
+
+int resolve(ASTNode* ast, Environment* global, char* error) {
+    error[0] = '\0';
+    Scope sc = { NULL, global, NULL, 0, 0, error, 0 };
+    declare_locals(&sc, ast);
+    resolve_node(&sc, ast);
+    return error[0] == '\0';
+}
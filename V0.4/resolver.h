@@ -0,0 +1,21 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include "parser.h"
+#include "vm.h"
+
+// Pass antara parse() dan eval(): memberi setiap pemakaian nama alamat
+// leksikal (depth, slot) sehingga eval() cukup mengindeks array slot
+// tanpa strcmp. Nama global didaftarkan langsung ke `global`.
+//
+// Aturan scope (seperti Python): nama yang di-assign di dalam fungsi,
+// parameter, variabel `untuk`, dan nama fungsi bersarang adalah lokal
+// untuk fungsi itu. Blok tidak membuat scope baru.
+//
+// Error (mis. parameter duplikat) tidak menghentikan proses: pesan error
+// pertama ditulis ke `error` (RESOLVE_ERROR_SIZE byte, sudah diakhiri
+// '\n') dan resolve() mengembalikan 0; 1 bila berhasil.
+#define RESOLVE_ERROR_SIZE 256
+int resolve(ASTNode* ast, Environment* global, char* error);
+
+#endif
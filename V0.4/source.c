@@ -0,0 +1,75 @@
+#define _DEFAULT_SOURCE
+#include "source.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Cadangkan length+1 byte anonim (nol), lalu petakan file di atas awal
+// cadangan dengan MAP_FIXED. Sisa halaman terakhir file diisi nol oleh
+// kernel, dan bila file pas kelipatan halaman, byte '\0' datang dari
+// halaman anonim berikutnya.
+static int map_file(SourceFile* src, int fd, size_t length) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mapped = (length + 1 + page - 1) / page * page;
+    char* base = mmap(NULL, mapped, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return 0;
+    if (mmap(base, length, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mapped);
+        return 0;
+    }
+    // Sumber dibaca sekali dari depan ke belakang
+    madvise(base, length, MADV_SEQUENTIAL);
+    src->data = base;
+    src->length = length;
+    src->mapped = mapped;
+    return 1;
+}
+
+static int read_file(SourceFile* src, int fd, size_t length) {
+    char* buf = malloc(length + 1);
+    if (!buf) {
+        fprintf(stderr, "Error: Alokasi memori gagal untuk sumber\n");
+        return 0;
+    }
+    size_t got = 0;
+    while (got < length) {
+        ssize_t n = read(fd, buf + got, length - got);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    buf[got] = '\0';
+    src->data = buf;
+    src->length = got;
+    src->mapped = 0;
+    return 1;
+}
+
+int source_open(SourceFile* src, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return 0;
+    }
+    size_t length = (size_t)st.st_size;
+    // File kosong atau bukan file biasa (pipe) tidak bisa dipetakan
+    int ok = (S_ISREG(st.st_mode) && length > 0 && map_file(src, fd, length))
+             || read_file(src, fd, length);
+    close(fd);
+    return ok;
+}
+
+void source_close(SourceFile* src) {
+    if (src->mapped) munmap((void*)src->data, src->mapped);
+    else free((void*)src->data);
+    src->data = NULL;
+    src->length = 0;
+    src->mapped = 0;
+}
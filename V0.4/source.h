@@ -0,0 +1,25 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <stddef.h>
+
+// File sumber yang dipetakan ke memori (mmap, read-only). Token hanya
+// menyimpan offset ke `data`, jadi pemetaan harus hidup selama token
+// dan pesan error parser masih dipakai.
+//
+// `data[length]` selalu '\0': lexer memakai sentinel itu, dan file yang
+// panjangnya kelipatan halaman tetap aman karena byte setelah akhir file
+// jatuh di halaman anonim (nol) yang dicadangkan di belakang pemetaan.
+// Bila mmap tidak tersedia/gagal, isi file dibaca ke buffer malloc.
+typedef struct {
+    const char* data;
+    size_t length;
+    size_t mapped;      // ukuran pemetaan; 0 = buffer malloc
+} SourceFile;
+
+// Mengembalikan 0 dengan errno terisi bila file tidak bisa dibuka; tidak
+// mencetak apa pun (driver -c melaporkannya per file).
+int source_open(SourceFile* src, const char* path);
+void source_close(SourceFile* src);
+
+#endif // SOURCE_H
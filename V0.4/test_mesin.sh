@@ -0,0 +1,21 @@
+#!/bin/sh
+# Jalankan setiap skrip dengan eval() dan register VM (-b) lalu bandingkan
+# keluarannya mulai dari "Hasil Eksekusi" (dump token/AST/bytecode berbeda).
+# Pakai: sh test_mesin.sh [file.niv ...]   (NIRVANA=./nirvana bawaan)
+NIRVANA=${NIRVANA:-./nirvana}
+[ $# -eq 0 ] && set -- test_nilai.niv test_fold.niv test_closure.niv
+gagal=0
+for f in "$@"; do
+    a=$("$NIRVANA" "$f" 2>&1 | sed -n '/^Hasil Eksekusi:/,$p')
+    b=$("$NIRVANA" -b "$f" 2>&1 | sed -n '/^Hasil Eksekusi:/,$p')
+    if [ "$a" = "$b" ]; then
+        echo "OK    $f"
+    else
+        echo "BEDA  $f"
+        printf '%s\n' "$a" > /tmp/nirvana_eval.$$
+        printf '%s\n' "$b" | diff /tmp/nirvana_eval.$$ - | sed 's/^/      /'
+        rm -f /tmp/nirvana_eval.$$
+        gagal=1
+    fi
+done
+exit $gagal
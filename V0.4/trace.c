@@ -0,0 +1,116 @@
+#include "trace.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NIRVANA_TRACE
+
+static const char* category_names[TRACE_CATEGORY_COUNT] = {
+    "lexer", "parser", "eval", "vm"
+};
+
+static const char* level_names[] = { "off", "info", "debug", "verbose" };
+
+#define TRACE_RING_SIZE 4096    // harus pangkat dua
+#define TRACE_MSG_SIZE 120
+
+typedef struct {
+    unsigned char category;
+    unsigned char level;
+    char msg[TRACE_MSG_SIZE];
+} TraceEvent;
+
+unsigned char trace_levels[TRACE_CATEGORY_COUNT];
+
+static TraceEvent ring[TRACE_RING_SIZE];
+static unsigned long ring_next = 0;     // total event yang pernah ditulis
+static unsigned long ring_first = 0;    // event tertua yang belum di-dump
+
+// Slot dipesan secara atomik agar parser di beberapa thread tidak menulis
+// slot yang sama; isi event dari thread berbeda bisa saling menimpa hanya
+// bila ring sudah berputar penuh selama satu vsnprintf.
+void trace_emit(TraceCategory cat, TraceLevel level, const char* fmt, ...) {
+    unsigned long slot = __atomic_fetch_add(&ring_next, 1, __ATOMIC_RELAXED);
+    TraceEvent* e = &ring[slot & (TRACE_RING_SIZE - 1)];
+    e->category = (unsigned char)cat;
+    e->level = (unsigned char)level;
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(e->msg, sizeof(e->msg), fmt, args);
+    va_end(args);
+}
+
+void trace_dump(FILE* out) {
+    if (ring_next - ring_first > TRACE_RING_SIZE) {
+        fprintf(out, "[trace] %lu event lama tertimpa\n",
+                ring_next - ring_first - TRACE_RING_SIZE);
+        ring_first = ring_next - TRACE_RING_SIZE;
+    }
+    for (unsigned long i = ring_first; i < ring_next; i++) {
+        TraceEvent* e = &ring[i & (TRACE_RING_SIZE - 1)];
+        fprintf(out, "[%s:%s] %s\n", category_names[e->category],
+                level_names[e->level], e->msg);
+    }
+    ring_first = ring_next;
+}
+
+// Juga dipanggil lewat exit(1) dari runtime error, jadi jejak terakhir
+// sebelum error ikut tercetak.
+static void dump_at_exit(void) {
+    trace_dump(stderr);
+}
+
+int trace_configure(const char* spec) {
+    TraceLevel level = TRACE_DEBUG;
+    const char* colon = strchr(spec, ':');
+    size_t names_len = colon ? (size_t)(colon - spec) : strlen(spec);
+    if (colon) {
+        int found = 0;
+        for (int l = TRACE_INFO; l <= TRACE_VERBOSE; l++) {
+            if (strcmp(colon + 1, level_names[l]) == 0) {
+                level = (TraceLevel)l;
+                found = 1;
+            }
+        }
+        if (!found) return 0;
+    }
+
+    unsigned char levels[TRACE_CATEGORY_COUNT] = {0};
+    const char* p = spec;
+    while (p < spec + names_len) {
+        const char* end = memchr(p, ',', spec + names_len - p);
+        if (!end) end = spec + names_len;
+        size_t len = (size_t)(end - p);
+        int found = 0;
+        for (int c = 0; c < TRACE_CATEGORY_COUNT; c++) {
+            if ((len == 3 && strncmp(p, "all", 3) == 0) ||
+                (strlen(category_names[c]) == len && strncmp(p, category_names[c], len) == 0)) {
+                levels[c] = (unsigned char)level;
+                found = 1;
+            }
+        }
+        if (!found) return 0;
+        p = end + 1;
+    }
+
+    static int registered = 0;
+    memcpy(trace_levels, levels, sizeof(levels));
+    if (!registered) {
+        atexit(dump_at_exit);
+        registered = 1;
+    }
+    return 1;
+}
+
+#else
+
+int trace_configure(const char* spec) {
+    (void)spec;
+    return 0;
+}
+
+void trace_dump(FILE* out) {
+    (void)out;
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+
+// Tracing terstruktur per kategori, pengganti fprintf "DEBUG:" lama.
+//
+// Tanpa -DNIRVANA_TRACE (build rilis) TRACE() tidak menghasilkan kode
+// sama sekali, termasuk evaluasi argumennya. Dengan -DNIRVANA_TRACE,
+// TRACE() yang tidak aktif hanya berupa satu perbandingan byte
+// trace_levels[kategori] >= level. Event yang aktif diformat ke ring
+// buffer di memori (event lama ditimpa), bukan langsung ke stderr, dan
+// baru dicetak lewat trace_dump().
+typedef enum {
+    TRACE_LEXER,
+    TRACE_PARSER,
+    TRACE_EVAL,
+    TRACE_VM,
+    TRACE_CATEGORY_COUNT
+} TraceCategory;
+
+typedef enum {
+    TRACE_OFF,
+    TRACE_INFO,
+    TRACE_DEBUG,
+    TRACE_VERBOSE
+} TraceLevel;
+
+#ifdef NIRVANA_TRACE
+extern unsigned char trace_levels[TRACE_CATEGORY_COUNT];
+
+void trace_emit(TraceCategory cat, TraceLevel level, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define TRACE(cat, level, ...) do { \
+        if (__builtin_expect(trace_levels[cat] >= (level), 0)) \
+            trace_emit(cat, level, __VA_ARGS__); \
+    } while (0)
+#else
+#define TRACE(cat, level, ...) ((void)0)
+#endif
+
+// Spesifikasi berbentuk "lexer,parser:verbose" atau "all"; level default
+// debug. Mengembalikan 0 bila spesifikasi tidak dikenal atau tracing
+// tidak dikompilasi.
+int trace_configure(const char* spec);
+// Cetak isi ring buffer (lama ke baru) lalu kosongkan.
+void trace_dump(FILE* out);
+
+#endif // TRACE_H
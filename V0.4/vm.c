@@ -1,67 +1,243 @@
+#define _POSIX_C_SOURCE 200809L
 #include "vm.h"
+#include "intern.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h> // NEW
 
-// Forward declarations
-static Value value_copy(Value v);
-static int is_truthy(Value v);
-
 // -------------------------------------------------------------------
 // Environment
 // -------------------------------------------------------------------
-Environment* env_new(Environment* parent) {
+Environment* env_new(Environment* parent, int slot_count) {
     Environment* env = malloc(sizeof(Environment));
     env->parent = parent;
-    env->bindings = NULL;
+    env->count = slot_count;
+    env->capacity = slot_count;
+    env->slots = slot_count > 0 ? malloc(sizeof(Value) * slot_count) : NULL;
+    env->names = NULL;
+    env->escaped = 0;
+    for (int i = 0; i < slot_count; i++) env->slots[i].type = VAL_UNDEFINED;
     return env;
 }
 
 void env_free(Environment* env) {
     if (!env) return;
-    Binding* b = env->bindings;
-    while (b) {
-        Binding* next = b->next;
-        free(b->name);
-        value_free(b->value);
-        free(b);
-        b = next;
-    }
+    for (int i = 0; i < env->count; i++) value_free(env->slots[i]);
+    free(env->slots);
+    free(env->names);
     free(env);
 }
 
-void env_set(Environment* env, const char* name, Value value) {
-    Binding* b = env->bindings;
-    while (b) {
-        if (strcmp(b->name, name) == 0) {
-            value_free(b->value);
-            b->value = value;
-            return;
+// Apakah `ancestor` ada di rantai `env` (termasuk env itu sendiri)?
+int env_within(Environment* env, Environment* ancestor) {
+    for (; env; env = env->parent) {
+        if (env == ancestor) return 1;
+    }
+    return 0;
+}
+
+static Environment** escaped_envs = NULL;
+static int escaped_count = 0;
+static int escaped_capacity = 0;
+
+// Env global (tanpa parent) selalu hidup; env yang sudah ditandai berarti
+// induknya juga sudah.
+void value_escape(Value v) {
+    Environment* env = v.type == VAL_CLOSURE ? v.closure.env
+                     : v.type == VAL_FUNCTION ? v.function.closure : NULL;
+    for (; env && env->parent && !env->escaped; env = env->parent) {
+        env->escaped = 1;
+        if (escaped_count >= escaped_capacity) {
+            escaped_capacity = escaped_capacity ? escaped_capacity * 2 : 16;
+            escaped_envs = realloc(escaped_envs, sizeof(Environment*) * escaped_capacity);
         }
-        b = b->next;
+        escaped_envs[escaped_count++] = env;
+        for (int i = 0; i < env->count; i++) value_escape(env->slots[i]);
     }
-    b = malloc(sizeof(Binding));
-    b->name = strdup(name);
-    b->value = value;
-    b->next = env->bindings;
-    env->bindings = b;
+}
+
+void env_release(Environment* env) {
+    if (!env->escaped) env_free(env);
+}
+
+void env_free_escaped(void) {
+    for (int i = 0; i < escaped_count; i++) env_free(escaped_envs[i]);
+    free(escaped_envs);
+    escaped_envs = NULL;
+    escaped_count = escaped_capacity = 0;
+}
+
+// Lookup berbasis nama hanya dipakai saat resolve / registrasi,
+// bukan di jalur eval.
+int env_find(Environment* env, const char* name) {
+    if (!env->names) return -1;
+    for (int i = 0; i < env->count; i++) {
+        if (env->names[i] == name) return i;
+    }
+    return -1;
+}
+
+int env_define(Environment* env, const char* name) {
+    int slot = env_find(env, name);
+    if (slot >= 0) return slot;
+    if (env->count >= env->capacity || !env->names) {
+        int old = env->names ? env->capacity : 0;
+        if (env->count >= env->capacity) {
+            env->capacity = env->capacity ? env->capacity * 2 : 16;
+            env->slots = realloc(env->slots, sizeof(Value) * env->capacity);
+        }
+        env->names = realloc(env->names, sizeof(const char*) * env->capacity);
+        for (int i = old; i < env->capacity; i++) env->names[i] = NULL;
+    }
+    slot = env->count++;
+    env->names[slot] = name;
+    env->slots[slot].type = VAL_UNDEFINED;
+    return slot;
+}
+
+void env_set(Environment* env, const char* name, Value value) {
+    int slot = env_define(env, intern_cstr(name));
+    value_free(env->slots[slot]);
+    env->slots[slot] = value;
 }
 
 Value env_get(Environment* env, const char* name) {
+    name = intern_cstr(name);
     for (Environment* e = env; e; e = e->parent) {
-        Binding* b = e->bindings;
-        while (b) {
-            if (strcmp(b->name, name) == 0) {
-                return value_copy(b->value);
-            }
-            b = b->next;
+        int slot = env_find(e, name);
+        if (slot >= 0 && e->slots[slot].type != VAL_UNDEFINED) {
+            return value_copy(e->slots[slot]);
         }
     }
     fprintf(stderr, "Runtime Error: Undefined variable '%s'\n", name);
     exit(1);
 }
 
+// -------------------------------------------------------------------
+// Stack frame panggilan eval()
+// -------------------------------------------------------------------
+// Environment frame fungsi beserta slot-slotnya diambil dari stack
+// berbentuk rantai chunk, jadi panggilan fungsi tidak melakukan malloc.
+// Chunk tidak pernah di-realloc sehingga pointer Environment tetap sah
+// selama frame hidup; chunk yang kosong disimpan untuk dipakai ulang.
+// Frame yang bisa ditangkap closure tidak di sini (lihat call_frame_push).
+#define FRAME_CHUNK_SIZE (256 * 1024)
+
+typedef struct FrameChunk {
+    struct FrameChunk* prev;
+    struct FrameChunk* next;
+    size_t used;
+    size_t size;
+    char data[];
+} FrameChunk;
+
+static FrameChunk* frame_chunk = NULL;
+
+static Environment* frame_push(Environment* parent, int slot_count) {
+    size_t bytes = sizeof(Environment) + sizeof(Value) * slot_count;
+    FrameChunk* c = frame_chunk;
+    if (!c || c->used + bytes > c->size) {
+        FrameChunk* next = c ? c->next : NULL;
+        if (!next || next->size < bytes) {
+            size_t size = bytes > FRAME_CHUNK_SIZE ? bytes : FRAME_CHUNK_SIZE;
+            FrameChunk* fresh = malloc(sizeof(FrameChunk) + size);
+            if (!fresh) {
+                fprintf(stderr, "Runtime Error: Stack panggilan habis\n");
+                exit(1);
+            }
+            fresh->size = size;
+            fresh->prev = c;
+            fresh->next = next;   // chunk cadangan yang terlalu kecil tetap dirantai
+            if (next) next->prev = fresh;
+            if (c) c->next = fresh;
+            next = fresh;
+        }
+        next->used = 0;
+        frame_chunk = c = next;
+    }
+    Environment* env = (Environment*)(c->data + c->used);
+    c->used += bytes;
+    env->parent = parent;
+    env->slots = (Value*)(env + 1);
+    env->count = slot_count;
+    env->capacity = slot_count;
+    env->names = NULL;
+    env->escaped = 0;
+    for (int i = 0; i < slot_count; i++) env->slots[i].type = VAL_UNDEFINED;
+    return env;
+}
+
+// Frame dilepas LIFO: harus frame teratas.
+static void frame_pop(Environment* env) {
+    for (int i = 0; i < env->count; i++) value_free(env->slots[i]);
+    FrameChunk* c = frame_chunk;
+    c->used = (char*)env - c->data;
+    if (c->used == 0 && c->prev) frame_chunk = c->prev;
+}
+
+// Panggilan ekor `kembali f(...)`: AST_RETURN hanya mengevaluasi argumen
+// ke buffer ini lalu menandai pending; pemanggil terdekat (AST_CALL) yang
+// melepas frame-nya dan menjalankan f di frame baru dalam loop yang sama.
+// Jadi rekursi ekor tidak menambah stack C maupun frame stack.
+static struct {
+    bool pending;
+    ASTNode* func_node;
+    Environment* closure;
+    Value* args;
+    int capacity;
+} tail_call = { false, NULL, NULL, NULL, 0 };
+
+static int call_depth = 0;   // jumlah fungsi user yang sedang berjalan
+
+// Fungsi yang mendefinisikan fungsi bersarang (own_env) mendapat frame di
+// heap, bukan di frame stack, karena closure-nya bisa hidup lebih lama
+// dari frame itu. Closure yang masih menunjuk env-nya saat frame selesai
+// (nilai kembali atau argumen panggilan ekor) membuat env itu lolos.
+static Environment* call_frame_push(ASTNode* func_node, Environment* closure) {
+    int n = func_node->function.local_count;
+    return func_node->function.own_env ? env_new(closure, n) : frame_push(closure, n);
+}
+
+static void call_frame_pop(ASTNode* func_node, Environment* env, Value result) {
+    if (!func_node->function.own_env) {
+        frame_pop(env);
+        return;
+    }
+    if (result.type == VAL_FUNCTION && env_within(result.function.closure, env)) {
+        value_escape(result);
+    }
+    if (tail_call.pending) {
+        for (int i = 0; i < tail_call.func_node->function.param_count; i++) {
+            Value arg = tail_call.args[i];
+            if (arg.type == VAL_FUNCTION && env_within(arg.function.closure, env)) value_escape(arg);
+        }
+    }
+    env_release(env);
+}
+
+void frame_stack_free(void) {
+    if (!frame_chunk) return;
+    FrameChunk* c = frame_chunk;
+    while (c->prev) c = c->prev;
+    while (c) {
+        FrameChunk* next = c->next;
+        free(c);
+        c = next;
+    }
+    frame_chunk = NULL;
+    free(tail_call.args);
+    tail_call.args = NULL;
+    tail_call.capacity = 0;
+}
+
+// Jalur cepat eval: alamat leksikal (depth, slot) dari resolver.
+static inline Value* env_slot(Environment* env, int depth, int slot) {
+    while (depth-- > 0) env = env->parent;
+    return &env->slots[slot];
+}
+
 // -------------------------------------------------------------------
 // Value constructors
 // -------------------------------------------------------------------
@@ -80,9 +256,14 @@ Value value_float(double f) {
 }
 
 Value value_string(const char* s) {
+    int len = strlen(s);
+    StringObj* str = malloc(sizeof(StringObj) + len + 1);
+    str->refcount = 1;
+    str->length = len;
+    memcpy(str->chars, s, len + 1);
     Value v;
     v.type = VAL_STRING;
-    v.string = strdup(s);
+    v.string = str;
     return v;
 }
 
@@ -100,21 +281,59 @@ Value value_null() {
 }
 
 Value value_array() {
+    ArrayObj* a = malloc(sizeof(ArrayObj));
+    a->refcount = 1;
+    a->count = 0;
+    a->capacity = 4;
+    a->elements = malloc(sizeof(Value) * a->capacity);
     Value v;
     v.type = VAL_ARRAY;
-    v.array.count = 0;
-    v.array.capacity = 4;
-    v.array.elements = malloc(sizeof(Value) * v.array.capacity);
+    v.array = a;
     return v;
 }
 
+// Copy-on-write: pastikan `arr` memegang payload miliknya sendiri
+// sebelum dimutasi.
+static void array_make_unique(Value* arr) {
+    ArrayObj* old = arr->array;
+    if (old->refcount == 1) return;
+    ArrayObj* a = malloc(sizeof(ArrayObj));
+    a->refcount = 1;
+    a->count = old->count;
+    a->capacity = old->capacity;
+    a->elements = malloc(sizeof(Value) * a->capacity);
+    for (int i = 0; i < a->count; i++) {
+        a->elements[i] = value_copy(old->elements[i]);
+    }
+    old->refcount--;
+    arr->array = a;
+}
+
 void array_append(Value* arr, Value v) {
     if (arr->type != VAL_ARRAY) return;
-    if (arr->array.count >= arr->array.capacity) {
-        arr->array.capacity *= 2;
-        arr->array.elements = realloc(arr->array.elements, sizeof(Value) * arr->array.capacity);
+    array_make_unique(arr);
+    ArrayObj* a = arr->array;
+    if (a->count >= a->capacity) {
+        a->capacity *= 2;
+        a->elements = realloc(a->elements, sizeof(Value) * a->capacity);
     }
-    arr->array.elements[arr->array.count++] = v;
+    a->elements[a->count++] = v;
+}
+
+Value value_range(int start, int end, int step) {
+    Value v;
+    v.type = VAL_RANGE;
+    v.range.start = start;
+    v.range.end = end;
+    v.range.step = step;
+    return v;
+}
+
+int range_length(Range r) {
+    long long span = (long long)r.end - r.start;
+    long long n = r.step > 0 ? (span + r.step - 1) / r.step
+                             : (span + r.step + 1) / r.step;
+    return n > 0 ? (int)n : 0;
 }
 
 Value value_function(ASTNode* func_node, Environment* closure) {
@@ -136,43 +355,28 @@ Value value_native(const char* name, Value (*func)(Value* args, int count)) {
 // -------------------------------------------------------------------
 // Value copy and free
 // -------------------------------------------------------------------
-static Value value_copy(Value v) {
-    Value res;
-    res.type = v.type;
+// Salinan berbagi payload: O(1) untuk semua tipe.
+Value value_copy(Value v) {
     switch (v.type) {
-        case VAL_NUMBER: res.number = v.number; break;
-        case VAL_FLOAT: res.float_num = v.float_num; break;
-        case VAL_BOOLEAN: res.boolean = v.boolean; break;
-        case VAL_NULL: break;
-        case VAL_STRING: res.string = strdup(v.string); break;
-        case VAL_ARRAY:
-            res.array.count = v.array.count;
-            res.array.capacity = v.array.capacity;
-            res.array.elements = malloc(sizeof(Value) * res.array.capacity);
-            for (int i = 0; i < res.array.count; i++) {
-                res.array.elements[i] = value_copy(v.array.elements[i]);
-            }
-            break;
-        case VAL_FUNCTION:
-            res.function.func_node = v.function.func_node;
-            res.function.closure = v.function.closure;
-            break;
-        case VAL_NATIVE:
-            res.native.name = v.native.name;
-            res.native.func = v.native.func;
-            break;
+        case VAL_STRING: v.string->refcount++; break;
+        case VAL_ARRAY: v.array->refcount++; break;
+        default: break;
     }
-    return res;
+    return v;
 }
 
 void value_free(Value v) {
     switch (v.type) {
-        case VAL_STRING: free(v.string); break;
+        case VAL_STRING:
+            if (--v.string->refcount == 0) free(v.string);
+            break;
         case VAL_ARRAY:
-            for (int i = 0; i < v.array.count; i++) {
-                value_free(v.array.elements[i]);
+            if (--v.array->refcount > 0) break;
+            for (int i = 0; i < v.array->count; i++) {
+                value_free(v.array->elements[i]);
             }
-            free(v.array.elements);
+            free(v.array->elements);
+            free(v.array);
             break;
         case VAL_FUNCTION:
             // closure tidak di-free di sini (sementara biarkan)
@@ -184,15 +388,17 @@ void value_free(Value v) {
 // -------------------------------------------------------------------
 // Truthy check
 // -------------------------------------------------------------------
-static int is_truthy(Value v) {
+int is_truthy(Value v) {
     switch (v.type) {
         case VAL_NUMBER: return v.number != 0;
         case VAL_FLOAT: return v.float_num != 0.0;
         case VAL_BOOLEAN: return v.boolean;
-        case VAL_STRING: return v.string[0] != '\0';
-        case VAL_ARRAY: return v.array.count > 0;
+        case VAL_STRING: return v.string->length > 0;
+        case VAL_ARRAY: return v.array->count > 0;
+        case VAL_RANGE: return range_length(v.range) > 0;
         case VAL_FUNCTION: return 1;
         case VAL_NATIVE: return 1;
+        case VAL_CLOSURE: return 1;
         case VAL_NULL: return 0;
         default: return 0;
     }
@@ -210,50 +416,159 @@ Value native_print(Value* args, int count) {
     return value_null();
 }
 
+// range(end), range(start, end), range(start, end, step)
 Value native_range(Value* args, int count) {
-    int start = 0, end;
-    if (count == 1) {
-        if (args[0].type != VAL_NUMBER) {
+    int start = 0, end, step = 1;
+    if (count < 1 || count > 3) {
+        fprintf(stderr, "range: jumlah argumen salah\n");
+        exit(1);
+    }
+    for (int i = 0; i < count; i++) {
+        if (args[i].type != VAL_NUMBER) {
             fprintf(stderr, "range: argumen harus angka\n");
             exit(1);
         }
+    }
+    if (count == 1) {
         end = args[0].number;
-    } else if (count == 2) {
-        if (args[0].type != VAL_NUMBER || args[1].type != VAL_NUMBER) {
-            fprintf(stderr, "range: argumen harus angka\n");
-            exit(1);
-        }
+    } else {
         start = args[0].number;
         end = args[1].number;
-    } else {
-        fprintf(stderr, "range: jumlah argumen salah\n");
-        exit(1);
+        if (count == 3) step = args[2].number;
     }
-    Value arr = value_array();
-    for (int i = start; i < end; i++) {
-        array_append(&arr, value_number(i));
+    if (step == 0) {
+        fprintf(stderr, "range: step tidak boleh 0\n");
+        exit(1);
     }
-    return arr;
+    return value_range(start, end, step);
+}
+
+void register_builtins(Environment* global) {
+    env_set(global, "cetak", value_native("cetak", native_print));
+    env_set(global, "range", value_native("range", native_range));
+    env_set(global, "print", value_native("print", native_print)); // English version
 }
 
 void print_value(Value v) {
     switch (v.type) {
         case VAL_NUMBER: printf("%d", v.number); break;
         case VAL_FLOAT: printf("%g", v.float_num); break;
-        case VAL_STRING: printf("\"%s\"", v.string); break;
+        case VAL_STRING: printf("\"%s\"", v.string->chars); break;
         case VAL_BOOLEAN: printf(v.boolean ? "benar" : "salah"); break;
         case VAL_NULL: printf("kosong"); break;
         case VAL_ARRAY:
             printf("[");
-            for (int i = 0; i < v.array.count; i++) {
-                print_value(v.array.elements[i]);
-                if (i < v.array.count - 1) printf(", ");
+            for (int i = 0; i < v.array->count; i++) {
+                print_value(v.array->elements[i]);
+                if (i < v.array->count - 1) printf(", ");
             }
             printf("]");
             break;
+        case VAL_RANGE: {
+            int n = range_length(v.range);
+            printf("[");
+            for (int i = 0; i < n; i++) {
+                printf("%d", v.range.start + i * v.range.step);
+                if (i < n - 1) printf(", ");
+            }
+            printf("]");
+            break;
+        }
         case VAL_FUNCTION: printf("<fungsi>"); break;
+        case VAL_CLOSURE: printf("<fungsi>"); break;
         case VAL_NATIVE: printf("<native %s>", v.native.name); break;
+        case VAL_UNDEFINED: printf("<undefined>"); break;
+    }
+}
+
+// -------------------------------------------------------------------
+// Operators
+// -------------------------------------------------------------------
+// Semantik operator dipakai bersama oleh eval() dan register VM (regvm.c).
+// Operand dipinjam, tidak di-free.
+Value value_binary(TokenType op, Value left, Value right, int line) {
+    Value result;
+    // Handle number operations
+    if (left.type == VAL_NUMBER && right.type == VAL_NUMBER) {
+        int a = left.number, b = right.number;
+        switch (op) {
+            case TOKEN_PLUS: result = value_number(a + b); break;
+            case TOKEN_MINUS: result = value_number(a - b); break;
+            case TOKEN_BINTANG: result = value_number(a * b); break;
+            case TOKEN_GARING: result = value_number(a / b); break;
+            case TOKEN_PERSEN: result = value_number(a % b); break;
+            case TOKEN_LT: result = value_boolean(a < b); break;
+            case TOKEN_GT: result = value_boolean(a > b); break;
+            case TOKEN_LTE: result = value_boolean(a <= b); break;
+            case TOKEN_GTE: result = value_boolean(a >= b); break;
+            case TOKEN_EQ: result = value_boolean(a == b); break;
+            case TOKEN_NEQ: result = value_boolean(a != b); break;
+            case TOKEN_AND: result = value_boolean(a && b); break;
+            case TOKEN_OR: result = value_boolean(a || b); break;
+            default: result = value_null();
+        }
+    } else if (left.type == VAL_FLOAT || right.type == VAL_FLOAT ||
+               left.type == VAL_NUMBER || right.type == VAL_NUMBER) {
+        double a = (left.type == VAL_NUMBER) ? left.number :
+                   (left.type == VAL_FLOAT) ? left.float_num : 0;
+        double b = (right.type == VAL_NUMBER) ? right.number :
+                   (right.type == VAL_FLOAT) ? right.float_num : 0;
+        switch (op) {
+            case TOKEN_PLUS: result = value_float(a + b); break;
+            case TOKEN_MINUS: result = value_float(a - b); break;
+            case TOKEN_BINTANG: result = value_float(a * b); break;
+            case TOKEN_GARING: result = value_float(a / b); break;
+            case TOKEN_LT: result = value_boolean(a < b); break;
+            case TOKEN_GT: result = value_boolean(a > b); break;
+            case TOKEN_LTE: result = value_boolean(a <= b); break;
+            case TOKEN_GTE: result = value_boolean(a >= b); break;
+            case TOKEN_EQ: result = value_boolean(a == b); break;
+            case TOKEN_NEQ: result = value_boolean(a != b); break;
+            default: result = value_null();
+        }
+    } else {
+        fprintf(stderr, "Runtime Error: Operasi binary tidak didukung di baris %d\n", line);
+        exit(1);
+    }
+    return result;
+}
+
+Value value_unary(TokenType op, Value operand, int line) {
+    Value result;
+    if (op == TOKEN_MINUS) {
+        if (operand.type == VAL_NUMBER) result = value_number(-operand.number);
+        else if (operand.type == VAL_FLOAT) result = value_float(-operand.float_num);
+        else {
+            fprintf(stderr, "Runtime Error: Unary minus pada non-angka di baris %d\n", line);
+            exit(1);
+        }
+    } else if (op == TOKEN_NOT) {
+        result = value_boolean(!is_truthy(operand));
+    } else {
+        result = value_null();
+    }
+    return result;
+}
+
+Value value_index(Value obj, Value idx, int line) {
+    if (obj.type != VAL_ARRAY && obj.type != VAL_RANGE) {
+        fprintf(stderr, "Runtime Error: Pengindeksan pada non-array di baris %d\n", line);
+        exit(1);
     }
+    if (idx.type != VAL_NUMBER) {
+        fprintf(stderr, "Runtime Error: Indeks array harus angka di baris %d\n", line);
+        exit(1);
+    }
+    int i = idx.number;
+    int len = obj.type == VAL_RANGE ? range_length(obj.range) : obj.array->count;
+    if (i < 0 || i >= len) {
+        fprintf(stderr, "Runtime Error: Indeks array di luar batas di baris %d\n", line);
+        exit(1);
+    }
+    Value elem = obj.type == VAL_RANGE
+        ? value_number(obj.range.start + i * obj.range.step)
+        : value_copy(obj.array->elements[i]);
+    return elem;
 }
 
 // -------------------------------------------------------------------
@@ -274,155 +589,111 @@ Value eval(ASTNode* node, Environment* env, bool* returned) {
             Value arr = value_array();
             for (int i = 0; i < node->array.count; i++) {
                 Value elem = eval(node->array.elements[i], env, returned);
+                if (elem.type == VAL_FUNCTION) value_escape(elem);
                 array_append(&arr, elem);
             }
             return arr;
         }
         case AST_IDENTIFIER: {
-            return env_get(env, node->name);
+            Value* v = env_slot(env, node->depth, node->slot);
+            if (v->type == VAL_UNDEFINED) {
+                fprintf(stderr, "Runtime Error: Undefined variable '%s'\n", node->name);
+                exit(1);
+            }
+            return value_copy(*v);
         }
         case AST_BINARY: {
             Value left = eval(node->binary.left, env, returned);
             Value right = eval(node->binary.right, env, returned);
-            Value result;
-            // Handle number operations
-            if (left.type == VAL_NUMBER && right.type == VAL_NUMBER) {
-                int a = left.number, b = right.number;
-                switch (node->binary.op) {
-                    case TOKEN_PLUS: result = value_number(a + b); break;
-                    case TOKEN_MINUS: result = value_number(a - b); break;
-                    case TOKEN_BINTANG: result = value_number(a * b); break;
-                    case TOKEN_GARING: result = value_number(a / b); break;
-                    case TOKEN_PERSEN: result = value_number(a % b); break;
-                    case TOKEN_LT: result = value_boolean(a < b); break;
-                    case TOKEN_GT: result = value_boolean(a > b); break;
-                    case TOKEN_LTE: result = value_boolean(a <= b); break;
-                    case TOKEN_GTE: result = value_boolean(a >= b); break;
-                    case TOKEN_EQ: result = value_boolean(a == b); break;
-                    case TOKEN_NEQ: result = value_boolean(a != b); break;
-                    case TOKEN_AND: result = value_boolean(a && b); break;
-                    case TOKEN_OR: result = value_boolean(a || b); break;
-                    default: result = value_null();
-                }
-            } else if (left.type == VAL_FLOAT || right.type == VAL_FLOAT ||
-                       left.type == VAL_NUMBER || right.type == VAL_NUMBER) {
-                double a = (left.type == VAL_NUMBER) ? left.number :
-                           (left.type == VAL_FLOAT) ? left.float_num : 0;
-                double b = (right.type == VAL_NUMBER) ? right.number :
-                           (right.type == VAL_FLOAT) ? right.float_num : 0;
-                switch (node->binary.op) {
-                    case TOKEN_PLUS: result = value_float(a + b); break;
-                    case TOKEN_MINUS: result = value_float(a - b); break;
-                    case TOKEN_BINTANG: result = value_float(a * b); break;
-                    case TOKEN_GARING: result = value_float(a / b); break;
-                    case TOKEN_LT: result = value_boolean(a < b); break;
-                    case TOKEN_GT: result = value_boolean(a > b); break;
-                    case TOKEN_LTE: result = value_boolean(a <= b); break;
-                    case TOKEN_GTE: result = value_boolean(a >= b); break;
-                    case TOKEN_EQ: result = value_boolean(a == b); break;
-                    case TOKEN_NEQ: result = value_boolean(a != b); break;
-                    default: result = value_null();
-                }
-            } else {
-                fprintf(stderr, "Runtime Error: Operasi binary tidak didukung di baris %d\n", node->line);
-                exit(1);
-            }
+            Value result = value_binary(node->binary.op, left, right, node->line);
             value_free(left);
             value_free(right);
             return result;
         }
         case AST_UNARY: {
             Value operand = eval(node->unary.operand, env, returned);
-            Value result;
-            if (node->unary.op == TOKEN_MINUS) {
-                if (operand.type == VAL_NUMBER) result = value_number(-operand.number);
-                else if (operand.type == VAL_FLOAT) result = value_float(-operand.float_num);
-                else {
-                    fprintf(stderr, "Runtime Error: Unary minus pada non-angka di baris %d\n", node->line);
-                    exit(1);
-                }
-            } else if (node->unary.op == TOKEN_NOT) {
-                result = value_boolean(!is_truthy(operand));
-            } else {
-                result = value_null();
-            }
+            Value result = value_unary(node->unary.op, operand, node->line);
             value_free(operand);
             return result;
         }
         case AST_ASSIGN: {
             Value val = eval(node->assign.value, env, returned);
-            env_set(env, node->assign.name, val); // env mengambil alih kepemilikan
+            Environment* target = env;
+            for (int d = node->depth; d > 0; d--) target = target->parent;
+            // Scope tujuan yang bukan keturunan env closure bisa hidup
+            // lebih lama dari env itu
+            if (val.type == VAL_FUNCTION && !env_within(target, val.function.closure)) {
+                value_escape(val);
+            }
+            Value* slot = &target->slots[node->slot];
+            value_free(*slot);
+            *slot = val; // env mengambil alih kepemilikan
             return value_copy(val); // kembalikan salinan untuk ekspresi
         }
         case AST_CALL: {
-            Value callee = env_get(env, node->call.name);
-            Value* args = malloc(sizeof(Value) * node->call.arg_count);
-            for (int i = 0; i < node->call.arg_count; i++) {
-                args[i] = eval(node->call.args[i], env, returned);
+            Value* callee_slot = env_slot(env, node->depth, node->slot);
+            if (callee_slot->type == VAL_UNDEFINED) {
+                fprintf(stderr, "Runtime Error: Undefined variable '%s'\n", node->call.name);
+                exit(1);
             }
+            Value callee = *callee_slot;   // fungsi tidak punya refcount
+            int argc = node->call.arg_count;
             Value result;
             if (callee.type == VAL_NATIVE) {
-                result = callee.native.func(args, node->call.arg_count);
-                for (int i = 0; i < node->call.arg_count; i++) {
-                    value_free(args[i]);
+                // Argumen native juga ditaruh di frame stack, bukan malloc.
+                Environment* args = frame_push(NULL, argc);
+                for (int i = 0; i < argc; i++) {
+                    args->slots[i] = eval(node->call.args[i], env, returned);
                 }
-                free(args);
+                result = callee.native.func(args->slots, argc);
+                frame_pop(args);
             } else if (callee.type == VAL_FUNCTION) {
                 ASTNode* func_node = callee.function.func_node;
-                Environment* closure = callee.function.closure;
 
                 // Check argument count
-                if (node->call.arg_count != func_node->function.param_count) {
+                if (argc != func_node->function.param_count) {
                     fprintf(stderr, "Runtime Error: Jumlah argumen salah untuk fungsi '%s'. Diharapkan %d, didapat %d di baris %d\n",
-                            node->call.name, func_node->function.param_count, node->call.arg_count, node->line);
+                            node->call.name, func_node->function.param_count, argc, node->line);
                     exit(1);
                 }
 
-                // Create a new environment for the function call
-                Environment* call_env = env_new(closure);
-
-                // Bind parameters to arguments
-                for (int i = 0; i < node->call.arg_count; i++) {
-                    env_set(call_env, func_node->function.params[i], args[i]);
-                }
-                
-                // Execute function body
-                bool func_returned = false; // New flag for this function call
-                result = eval(func_node->function.body, call_env, &func_returned);
-
-                // Clean up arguments
-                for (int i = 0; i < node->call.arg_count; i++) {
-                    value_free(args[i]);
+                // Frame baru di stack; argumen dievaluasi langsung ke slot
+                // parameter 0..argc-1. Panggilan bersarang saat evaluasi
+                // argumen mendorong frame di atasnya dan sudah di-pop
+                // sebelum kembali ke sini.
+                Environment* call_env = call_frame_push(func_node, callee.function.closure);
+                for (int i = 0; i < argc; i++) {
+                    call_env->slots[i] = eval(node->call.args[i], env, returned);
                 }
-                free(args);
-
-                // Clean up call environment
-                env_free(call_env);
 
+                // Execute function body; panggilan ekor diulang di sini.
+                TRACE(TRACE_EVAL, TRACE_DEBUG, "panggil %s (kedalaman %d) di baris %d",
+                      node->call.name, call_depth + 1, node->line);
+                call_depth++;
+                while (1) {
+                    bool func_returned = false; // New flag for this function call
+                    result = eval(func_node->function.body, call_env, &func_returned);
+                    call_frame_pop(func_node, call_env, result);
+                    if (!tail_call.pending) break;
+                    tail_call.pending = false;
+                    value_free(result);
+                    func_node = tail_call.func_node;
+                    call_env = call_frame_push(func_node, tail_call.closure);
+                    for (int i = 0; i < func_node->function.param_count; i++) {
+                        call_env->slots[i] = tail_call.args[i];
+                    }
+                }
+                call_depth--;
             } else {
                 fprintf(stderr, "Runtime Error: Mencoba memanggil non-fungsi di baris %d\n", node->line);
                 exit(1);
             }
-            value_free(callee);
             return result;
         }
         case AST_INDEX: {
             Value obj = eval(node->index.object, env, returned);
             Value idx = eval(node->index.index, env, returned);
-            if (obj.type != VAL_ARRAY) {
-                fprintf(stderr, "Runtime Error: Pengindeksan pada non-array di baris %d\n", node->line);
-                exit(1);
-            }
-            if (idx.type != VAL_NUMBER) {
-                fprintf(stderr, "Runtime Error: Indeks array harus angka di baris %d\n", node->line);
-                exit(1);
-            }
-            int i = idx.number;
-            if (i < 0 || i >= obj.array.count) {
-                fprintf(stderr, "Runtime Error: Indeks array di luar batas di baris %d\n", node->line);
-                exit(1);
-            }
-            Value elem = value_copy(obj.array.elements[i]);
+            Value elem = value_index(obj, idx, node->line);
             value_free(obj);
             value_free(idx);
             return elem;
@@ -432,6 +703,7 @@ Value eval(ASTNode* node, Environment* env, bool* returned) {
             for (int i = 0; i < node->block.count; i++) {
                 value_free(last);
                 last = eval(node->block.statements[i], env, returned);
+                if (returned && *returned) break;
             }
             return last;
         }
@@ -455,38 +727,94 @@ Value eval(ASTNode* node, Environment* env, bool* returned) {
                 if (!truth) break;
                 value_free(result);
                 result = eval(node->while_stmt.body, env, returned);
+                if (returned && *returned) break;
             }
             return result;
         }
         case AST_FOR: {
             Value iterable = eval(node->for_stmt.iterable, env, returned);
+            Value result = value_null();
+            if (iterable.type == VAL_RANGE) {
+                // Iterasi langsung atas (start, end, step): memori konstan.
+                Range r = iterable.range;
+                for (long long i = r.start; r.step > 0 ? i < r.end : i > r.end; i += r.step) {
+                    Value* var = env_slot(env, node->depth, node->slot);
+                    value_free(*var);
+                    *var = value_number((int)i);
+                    value_free(result);
+                    result = eval(node->for_stmt.body, env, returned);
+                    if (returned && *returned) break;
+                }
+                return result;
+            }
             if (iterable.type != VAL_ARRAY) {
                 fprintf(stderr, "Runtime Error: Perulangan for memerlukan array di baris %d\n", node->line);
                 exit(1);
             }
-            Value result = value_null();
-            for (int i = 0; i < iterable.array.count; i++) {
-                Value elem = value_copy(iterable.array.elements[i]);
-                env_set(env, node->for_stmt.var_name, elem);
+            for (int i = 0; i < iterable.array->count; i++) {
+                Value* var = env_slot(env, node->depth, node->slot);
+                value_free(*var);
+                *var = value_copy(iterable.array->elements[i]);
                 value_free(result);
                 result = eval(node->for_stmt.body, env, returned);
+                if (returned && *returned) break;
             }
             value_free(iterable);
             return result;
         }
         // NEW: Handle Function Definition
         case AST_FUNCTION: {
-            Value func_val = value_function(node, env);
-            env_set(env, node->function.name, func_val);
+            Value* slot = env_slot(env, node->depth, node->slot);
+            value_free(*slot);
+            *slot = value_function(node, env);
             return value_null();
         }
         // NEW: Handle Return Statement
         case AST_RETURN: {
-            *returned = true;
+            // Nilai dievaluasi dulu: flag yang sudah menyala membuat eval()
+            // langsung mengembalikan null.
             Value ret_val = value_null();
+            ASTNode* call = node->return_stmt.value;
+            if (call && call->type == AST_CALL && call_depth > 0) {
+                Value callee = *env_slot(env, call->depth, call->slot);
+                // Closure yang menunjuk frame ini tidak bisa dipanggil ekor:
+                // frame ini dilepas sebelum fungsi tujuan berjalan.
+                if (callee.type == VAL_FUNCTION && callee.function.closure != env) {
+                    ASTNode* func_node = callee.function.func_node;
+                    int argc = call->call.arg_count;
+                    if (argc != func_node->function.param_count) {
+                        fprintf(stderr, "Runtime Error: Jumlah argumen salah untuk fungsi '%s'. Diharapkan %d, didapat %d di baris %d\n",
+                                call->call.name, func_node->function.param_count, argc, call->line);
+                        exit(1);
+                    }
+                    // Argumen dievaluasi ke frame sementara dulu: panggilan
+                    // ekor di dalam argumen juga memakai buffer tail_call.
+                    Environment* args = frame_push(NULL, argc);
+                    for (int i = 0; i < argc; i++) {
+                        args->slots[i] = eval(call->call.args[i], env, returned);
+                    }
+                    if (argc > tail_call.capacity) {
+                        tail_call.capacity = argc * 2;
+                        tail_call.args = realloc(tail_call.args, sizeof(Value) * tail_call.capacity);
+                    }
+                    for (int i = 0; i < argc; i++) {
+                        tail_call.args[i] = args->slots[i];
+                        args->slots[i].type = VAL_UNDEFINED;
+                    }
+                    frame_pop(args);
+                    TRACE(TRACE_EVAL, TRACE_DEBUG, "panggilan ekor %s di baris %d",
+                          call->call.name, call->line);
+                    tail_call.pending = true;
+                    tail_call.func_node = func_node;
+                    tail_call.closure = callee.function.closure;
+                    *returned = true;
+                    return ret_val;
+                }
+            }
             if (node->return_stmt.value) {
                 ret_val = eval(node->return_stmt.value, env, returned);
             }
+            *returned = true;
             return ret_val;
         }
         // NEW: Handle Expression Statement
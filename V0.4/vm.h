@@ -11,22 +11,44 @@ typedef enum {
     VAL_BOOLEAN,
     VAL_NULL,
     VAL_ARRAY,
+    VAL_RANGE,          // range(...) lazy: tidak pernah dimaterialisasi
     VAL_FUNCTION,
-    VAL_NATIVE
+    VAL_NATIVE,
+    VAL_CLOSURE,        // fungsi hasil kompilasi bytecode (regvm)
+    VAL_UNDEFINED       // slot yang belum pernah diisi (internal)
 } ValueType;
 
+// Payload string dan array hidup di heap dan dibagi antar Value dengan
+// reference counting: menyalin Value hanya menaikkan refcount. Array
+// disalin (copy-on-write) hanya saat dimutasi ketika masih dipakai bersama.
+typedef struct StringObj {
+    int refcount;
+    int length;
+    char chars[];
+} StringObj;
+
+typedef struct ArrayObj {
+    int refcount;
+    int count;
+    int capacity;
+    struct Value* elements;
+} ArrayObj;
+
+typedef struct {
+    int start;
+    int end;
+    int step;
+} Range;
+
 typedef struct Value {
     ValueType type;
     union {
         int number;
         double float_num;
-        char* string;
+        StringObj* string;
         int boolean;
-        struct {
-            struct Value* elements;
-            int count;
-            int capacity;
-        } array;
+        ArrayObj* array;
+        Range range;
         struct {
             struct ASTNode* func_node;   // AST_FUNCTION node
             struct Environment* closure; // environment saat definisi
@@ -35,28 +57,54 @@ typedef struct Value {
             const char* name;
             struct Value (*func)(struct Value* args, int arg_count);
         } native;
+        struct {
+            struct Proto* proto;         // lihat regvm.h
+            struct Environment* env;     // environment saat definisi
+        } closure;
     };
 } Value;
 
-// Definisikan Binding terlebih dahulu
-typedef struct Binding {
-    char* name;
-    Value value;
-    struct Binding* next;
-} Binding;
-
+// Environment berupa array slot datar. Resolver sudah menentukan slot
+// setiap nama, jadi frame fungsi tidak menyimpan nama sama sekali; hanya
+// scope global yang punya `names` (untuk resolver dan fungsi bawaan).
 typedef struct Environment {
     struct Environment* parent;
-    Binding* bindings;
+    Value* slots;
+    int count;
+    int capacity;
+    const char** names; // simbol intern; NULL untuk frame fungsi
+    int escaped;        // ditangkap closure yang hidup lebih lama dari frame-nya
 } Environment;
 
-Environment* env_new(Environment* parent);
+Environment* env_new(Environment* parent, int slot_count);
 void env_free(Environment* env);
+// env_find/env_define menerima simbol hasil intern() (dibandingkan per
+// pointer); env_set/env_get menerima string biasa dan meng-intern-nya.
+int env_find(Environment* env, const char* name);
+int env_define(Environment* env, const char* name);
 void env_set(Environment* env, const char* name, Value value);
 Value env_get(Environment* env, const char* name);
 
+// Closure yang keluar dari frame pembuatnya. Frame fungsi yang
+// mendefinisikan fungsi bersarang punya Environment di heap; bila
+// closure-nya bisa dipanggil setelah frame selesai (dikembalikan, disimpan
+// ke global, ke scope di luar env-nya, atau ke array), value_escape()
+// menandai env itu beserta induk dan env yang terjangkau dari slotnya.
+// env_release() tidak membebaskan env yang ditandai; env_free_escaped()
+// melepas semuanya di akhir program.
+int env_within(Environment* env, Environment* ancestor);
+void value_escape(Value v);
+void env_release(Environment* env);
+void env_free_escaped(void);
+
 Value eval(ASTNode* node, Environment* env, bool* returned);
+void frame_stack_free(void);
+Value value_binary(TokenType op, Value left, Value right, int line);
+Value value_unary(TokenType op, Value operand, int line);
+Value value_index(Value obj, Value idx, int line);
+int is_truthy(Value v);
 void print_value(Value v);
+Value value_copy(Value v);
 void value_free(Value v);
 
 Value value_number(int n);
@@ -66,11 +114,15 @@ Value value_boolean(int b);
 Value value_null(void);
 Value value_array(void);
 void array_append(Value* arr, Value v);
+Value value_range(int start, int end, int step);
+int range_length(Range r);
 Value value_function(ASTNode* func_node, Environment* closure);
 Value value_native(const char* name, Value (*func)(Value* args, int count));
 
 // Built-in functions
 Value native_print(Value* args, int count);
 Value native_range(Value* args, int count);
+// Daftarkan cetak/print/range ke environment global
+void register_builtins(Environment* global);
 
 #endif // VM_H
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "gc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static size_t object_size(GCObject* o) {
+    if (o->type == VAL_STRING) return sizeof(String) + ((String*)o)->length + 1;
+    return sizeof(Array) + sizeof(Value) * ((Array*)o)->capacity;
+}
+
+void* gc_realloc(VM* vm, void* ptr, size_t old_size, size_t new_size) {
+    Heap* h = &vm->heap;
+    if (new_size > old_size) {
+        h->bytes += new_size - old_size;
+        if (h->bytes > h->peak_bytes) h->peak_bytes = h->bytes;
+#ifdef NIRVANA_GC_STRESS
+        gc_collect(vm);
+#else
+        if (h->bytes > h->next_gc) gc_collect(vm);
+#endif
+    } else {
+        h->bytes -= old_size - new_size;
+    }
+    if (new_size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    void* p = realloc(ptr, new_size);
+    if (!p) {
+        fprintf(stderr, "Error: Alokasi memori gagal (heap %zu byte)\n", h->bytes);
+        exit(1);
+    }
+    return p;
+}
+
+GCObject* gc_new(VM* vm, ValueType type, size_t size) {
+    GCObject* o = gc_realloc(vm, NULL, 0, size);
+    o->type = (uint8_t)type;
+    o->marked = 0;
+    o->next = vm->heap.objects;
+    vm->heap.objects = o;
+    vm->heap.objects_allocated++;
+    return o;
+}
+
+// === MARK ===
+
+static void mark_object(Heap* h, GCObject* o) {
+    if (o->marked) return;
+    o->marked = 1;
+    if (o->type != VAL_ARRAY) return;
+    // Isi array ditandai belakangan dari antrian gray, bukan rekursif,
+    // supaya array bersarang dalam tidak menghabiskan stack C
+    if (h->gray_count >= h->gray_capacity) {
+        h->gray_capacity = h->gray_capacity ? h->gray_capacity * 2 : 64;
+        h->gray = realloc(h->gray, sizeof(GCObject*) * h->gray_capacity);
+        if (!h->gray) {
+            fprintf(stderr, "Error: Alokasi memori gagal untuk GC\n");
+            exit(1);
+        }
+    }
+    h->gray[h->gray_count++] = o;
+}
+
+static void mark_value(Heap* h, Value* v) {
+    if (v->type == VAL_STRING) mark_object(h, &v->s->gc);
+    else if (v->type == VAL_ARRAY) mark_object(h, &v->a->gc);
+}
+
+static void mark_roots(VM* vm) {
+    Heap* h = &vm->heap;
+    for (int i = 0; i < vm->func.num_regs; i++) mark_value(h, &vm->regs[i]);
+    for (int i = 0; i < vm->globals.count; i++) mark_value(h, &vm->globals.values[i]);
+    for (int i = 0; i < vm->func.num_constants; i++) mark_value(h, &vm->func.constants[i]);
+}
+
+static void trace(Heap* h) {
+    while (h->gray_count > 0) {
+        Array* a = (Array*)h->gray[--h->gray_count];
+        for (int i = 0; i < a->size; i++) mark_value(h, &a->data[i]);
+    }
+}
+
+// === SWEEP ===
+
+static void free_object(Heap* h, GCObject* o) {
+    size_t size = object_size(o);
+    h->bytes -= size;
+    h->bytes_freed += size;
+    h->objects_freed++;
+    if (o->type == VAL_ARRAY) free(((Array*)o)->data);
+    free(o);
+}
+
+static void sweep(Heap* h) {
+    GCObject** link = &h->objects;
+    while (*link) {
+        GCObject* o = *link;
+        if (o->marked) {
+            o->marked = 0;
+            link = &o->next;
+        } else {
+            *link = o->next;
+            free_object(h, o);
+        }
+    }
+}
+
+void gc_collect(VM* vm) {
+    Heap* h = &vm->heap;
+    clock_t start = clock();
+    mark_roots(vm);
+    trace(h);
+    sweep(h);
+    h->next_gc = h->bytes * GC_HEAP_GROW;
+    if (h->next_gc < GC_MIN_HEAP) h->next_gc = GC_MIN_HEAP;
+
+    double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    h->collections++;
+    h->pause_total_ms += ms;
+    if (ms > h->pause_max_ms) h->pause_max_ms = ms;
+}
+
+void gc_free_all(VM* vm) {
+    Heap* h = &vm->heap;
+    while (h->objects) {
+        GCObject* o = h->objects;
+        h->objects = o->next;
+        free_object(h, o);
+    }
+    free(h->gray);
+    h->gray = NULL;
+    h->gray_capacity = 0;
+}
+
+void gc_print_stats(VM* vm) {
+    Heap* h = &vm->heap;
+    fprintf(stderr, "[gc] %d koleksi, jeda total %.3f ms, maks %.3f ms\n",
+            h->collections, h->pause_total_ms, h->pause_max_ms);
+    fprintf(stderr, "[gc] %zu objek dialokasi, %zu dibebaskan (%zu KB), heap %zu KB, puncak %zu KB\n",
+            h->objects_allocated, h->objects_freed, h->bytes_freed / 1024,
+            h->bytes / 1024, h->peak_bytes / 1024);
+}
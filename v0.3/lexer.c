@@ -176,7 +176,10 @@ Token** lex(const char* input, int* token_count) {
             }
             
             // Skip empty lines and comments
-            if (*current == '\n' || *current == '#') {
+            if (*current == '#') {
+                while (*current != '\n' && *current != '\0') { current++; col++; }
+            }
+            if (*current == '\n' || *current == '\0') {
                 if (*current == '\n') { line++; col = 1; current++; }
                 continue;
             }
@@ -6,6 +6,7 @@
     #include "lexer.h"
     #include "parser.h"
     #include "vm.h"
+    #include "intern.h"
     #include <stdio.h>
     #include <stdlib.h>
     #include <string.h>
@@ -47,10 +48,49 @@
         free(tokens);
     }
 
+    char* read_file(const char* filename) {
+        FILE* file = fopen(filename, "r");
+        if (!file) {
+            fprintf(stderr, "Error: Cannot open file '%s'\n", filename);
+            return NULL;
+        }
+        
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        
+        char* buffer = malloc(size + 1);
+        if (!buffer) {
+            fprintf(stderr, "Error: Cannot allocate memory\n");
+            fclose(file);
+            return NULL;
+        }
+        
+        size_t got = fread(buffer, 1, size, file);
+        buffer[got] = '\0';
+        fclose(file);
+        return buffer;
+    }
+
     int main(int argc, char* argv[]) {
         print_banner();
         
-        int debug = (argc > 1 && strcmp(argv[1], "-d") == 0);
+        int debug = 0;
+        const char* filename = NULL;
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "-d") == 0) debug = 1;
+            else if (argv[i][0] != '-') filename = argv[i];
+        }
+        
+        // nirvana [-d] file.niv: jalankan file, bukan demo
+        if (filename) {
+            char* code = read_file(filename);
+            if (!code) return 1;
+            run_code(code, debug);
+            free(code);
+            intern_free_all();
+            return 0;
+        }
         
         // Test 1: For loop kecil
         printf("\n=== Test 1: For loop range(5) ===\n");
@@ -88,6 +128,7 @@
         printf("Code:\n%s\n", code4);
         run_code(code4, debug);
         
+        intern_free_all();
         return 0;
     }
     
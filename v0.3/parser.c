@@ -4,6 +4,7 @@
 #include <string.h>
 #include "parser.h"
 #include "lexer.h"
+#include "intern.h"
 
 static Token** tokens;
 static int token_count;
@@ -127,7 +128,7 @@ static ASTNode* parse_primary() {
     // Identifier atau call
     if (chk(TOKEN_NAMA) || chk(TOKEN_CETAK) || chk(TOKEN_RANGE)) {
         adv();
-        char* name = my_strdup(t->lexeme);
+        const char* name = intern_cstr(t->lexeme);
         
         // Function call
         if (mat(TOKEN_BUKA_KURUNG)) {
@@ -342,7 +343,7 @@ static ASTNode* parse_for() {
     if (!mat(TOKEN_DALAM)) error("Expected 'dalam' after variable");
     
     ASTNode* n = make_node(AST_FOR);
-    n->for_stmt.var_name = my_strdup(var->lexeme);
+    n->for_stmt.var_name = intern_cstr(var->lexeme);
     n->for_stmt.iterable = parse_expr();
     n->for_stmt.body = parse_block();
     
@@ -391,7 +392,7 @@ static ASTNode* parse_stmt() {
         Token* name = cur();
         adv(); adv();
         ASTNode* n = make_node(AST_ASSIGN);
-        n->assign.name = my_strdup(name->lexeme);
+        n->assign.name = intern_cstr(name->lexeme);
         n->assign.value = parse_expr();
         return n;
     }
@@ -526,7 +527,6 @@ void free_ast(ASTNode* n) {
     if (!n) return;
     switch (n->type) {
         case AST_STRING: free(n->string); break;
-        case AST_IDENTIFIER: free(n->name); break;
         
         // NEW: Free array elements
         case AST_ARRAY:
@@ -536,9 +536,8 @@ void free_ast(ASTNode* n) {
             
         case AST_BINARY: free_ast(n->binary.left); free_ast(n->binary.right); break;
         case AST_UNARY: free_ast(n->unary.operand); break;
-        case AST_ASSIGN: free(n->assign.name); free_ast(n->assign.value); break;
+        case AST_ASSIGN: free_ast(n->assign.value); break;
         case AST_CALL:
-            free(n->call.name);
             for (int i = 0; i < n->call.arg_count; i++) free_ast(n->call.args[i]);
             free(n->call.args);
             break;
@@ -565,7 +564,6 @@ void free_ast(ASTNode* n) {
             
         // NEW: Free for loop
         case AST_FOR:
-            free(n->for_stmt.var_name);
             free_ast(n->for_stmt.iterable);
             free_ast(n->for_stmt.body);
             break;
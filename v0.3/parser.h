@@ -39,7 +39,7 @@ typedef struct ASTNode {
         double float_num;
         char* string;
         int boolean;
-        char* name;
+        const char* name;       // simbol intern (intern.h)
         
         // NEW: Array literal
         struct {
@@ -62,13 +62,13 @@ typedef struct ASTNode {
         
         // Assignment
         struct {
-            char *name;
+            const char *name;
             struct ASTNode *value;
         } assign;
         
         // Function call
         struct {
-            char *name;
+            const char *name;
             struct ASTNode **args;
             int arg_count;
         } call;
@@ -100,15 +100,15 @@ typedef struct ASTNode {
         
         // NEW: For loop
         struct {
-            char *var_name;           // loop variable
+            const char *var_name;     // loop variable
             struct ASTNode *iterable; // range atau array
             struct ASTNode *body;
         } for_stmt;
         
         // Function definition
         struct {
-            char *name;
-            char **params;
+            const char *name;
+            const char **params;
             int param_count;
             struct ASTNode *body;
         } function;
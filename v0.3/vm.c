@@ -1,4 +1,6 @@
 #include "vm.h"
+#include "gc.h"
+#include "intern.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,22 +10,52 @@
 
 static Value make_int(int64_t i) { Value v = {VAL_INT, {.i=i}}; return v; }
 static Value make_float(double f) { Value v = {VAL_FLOAT, {.f=f}}; return v; }
-static Value make_string(const char* s) { Value v = {VAL_STRING, {.s=strdup(s)}}; return v; }
 static Value make_bool(int b) { Value v = {VAL_BOOL, {.i=b}}; return v; }
 static Value make_nil(void) { Value v = {VAL_NIL, {.i=0}}; return v; }
 
-Value make_array(void) {
-    Value v = {VAL_ARRAY, {0}};
-    v.a.data = NULL;
-    v.a.size = 0;
-    v.a.capacity = 0;
+// String dan array dialokasi di heap GC (gc.c)
+static Value make_string(VM* vm, const char* s) {
+    size_t len = strlen(s);
+    String* str = (String*)gc_new(vm, VAL_STRING, sizeof(String) + len + 1);
+    str->length = (int)len;
+    str->hash = 0;
+    memcpy(str->chars, s, len + 1);
+    Value v = {VAL_STRING, {.s = str}};
     return v;
 }
 
-void array_append(Array* arr, Value v) {
+// FNV-1a, disimpan di objek; 0 dicadangkan untuk "belum dihitung"
+static uint32_t string_hash(String* s) {
+    if (s->hash) return s->hash;
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < s->length; i++) h = (h ^ (unsigned char)s->chars[i]) * 16777619u;
+    s->hash = h ? h : 1;
+    return s->hash;
+}
+
+static inline int strings_equal(String* a, String* b) {
+    if (a == b) return 1;
+    if (a->length != b->length) return 0;
+    if (a->hash && b->hash && a->hash != b->hash) return 0;
+    return memcmp(a->chars, b->chars, a->length) == 0;
+}
+
+Value make_array(VM* vm) {
+    Array* a = (Array*)gc_new(vm, VAL_ARRAY, sizeof(Array));
+    a->data = NULL;
+    a->size = 0;
+    a->capacity = 0;
+    Value v = {VAL_ARRAY, {.a = a}};
+    return v;
+}
+
+// `arr` harus tercapai dari root: menumbuhkan buffer bisa memicu GC
+void array_append(VM* vm, Array* arr, Value v) {
     if (arr->size >= arr->capacity) {
-        arr->capacity = arr->capacity ? arr->capacity * 2 : 4;
-        arr->data = realloc(arr->data, sizeof(Value) * arr->capacity);
+        int capacity = arr->capacity ? arr->capacity * 2 : 4;
+        arr->data = gc_realloc(vm, arr->data, sizeof(Value) * arr->capacity,
+                               sizeof(Value) * capacity);
+        arr->capacity = capacity;
     }
     arr->data[arr->size++] = v;
 }
@@ -48,25 +80,70 @@ static int is_truthy(Value* v) {
     return 1;
 }
 
-static void free_value(Value* v) {
-    if (v->type == VAL_STRING && v->s) free(v->s);
-    if (v->type == VAL_ARRAY && v->a.data) free(v->a.data);
+// Dipakai bersama opcode biasa dan superinstruksinya (ADD/ADDK/
+// GETGLOBAL_ADD, SUB/SUBK, LT/LT_JMP, EQ/EQ_JMP). Hasil aritmetika
+// ditulis langsung ke dst (boleh sama dengan x/y) agar Value 24 byte
+// tidak dibangun di temporary lalu disalin.
+static inline void num_add(Value* dst, Value* x, Value* y) {
+    if (x->type == VAL_INT && y->type == VAL_INT) {
+        dst->i = x->i + y->i;
+        dst->type = VAL_INT;
+        return;
+    }
+    double l = 0, r = 0;
+    to_num(x, &l); to_num(y, &r);
+    dst->f = l + r;
+    dst->type = VAL_FLOAT;
+}
+
+static inline void num_sub(Value* dst, Value* x, Value* y) {
+    if (x->type == VAL_INT && y->type == VAL_INT) {
+        dst->i = x->i - y->i;
+        dst->type = VAL_INT;
+        return;
+    }
+    double l = 0, r = 0;
+    to_num(x, &l); to_num(y, &r);
+    dst->f = l - r;
+    dst->type = VAL_FLOAT;
+}
+
+static inline int num_less(Value* x, Value* y) {
+    if (x->type == VAL_INT && y->type == VAL_INT) return x->i < y->i;
+    double l = 0, r = 0;
+    to_num(x, &l); to_num(y, &r);
+    return l < r;
+}
+
+static inline int values_equal(Value* x, Value* y) {
+    if (x->type != y->type) return 0;
+    if (x->type == VAL_INT) return x->i == y->i;
+    if (x->type == VAL_FLOAT) return x->f == y->f;
+    if (x->type == VAL_STRING) return strings_equal(x->s, y->s);
+    return 0;
 }
 
 // === VM MANAGEMENT ===
 
 VM* vm_create(void) {
     VM* vm = calloc(1, sizeof(VM));
+    vm->heap.next_gc = GC_MIN_HEAP;
     return vm;
 }
 
 void vm_destroy(VM* vm) {
     if (!vm) return;
-    for (int i = 0; i < vm->func.num_constants; i++)
-        free_value(&vm->func.constants[i]);
+#ifdef NIRVANA_GC_STATS
+    gc_print_stats(vm);
+#endif
+    // Konstanta, global, dan register hanya meminjam objek heap
+    gc_free_all(vm);
     free(vm->func.constants);
+    free(vm->func.const_index);
     free(vm->func.code);
-    for (int i = 0; i < vm->num_globals; i++) free(vm->globals[i].name);
+    free(vm->globals.names);
+    free(vm->globals.values);
+    free(vm->globals.index);
     free(vm);
 }
 
@@ -78,79 +155,562 @@ static void emit(VM* vm, Instruction i) {
     vm->func.code[vm->func.code_size++] = i;
 }
 
+// Konstanta di-dedup lewat indeks hash (open addressing, seperti tabel
+// global) supaya skrip hasil generator dengan ratusan ribu literal tidak
+// dikompilasi kuadratik. Indeks > 0xFFFF dimuat lewat LOADKX.
+static uint32_t const_hash(Value* v) {
+    uint64_t bits = 0;
+    if (v->type == VAL_STRING) {
+        bits = string_hash(v->s);
+    } else if (v->type == VAL_FLOAT) {
+        memcpy(&bits, &v->f, sizeof(bits));
+    } else {
+        bits = (uint64_t)v->i;
+    }
+    return (uint32_t)((bits ^ (bits >> 32)) * 2654435761u) ^ v->type;
+}
+
+static void const_index_insert(Func* f, int idx) {
+    uint32_t mask = (uint32_t)f->const_index_capacity - 1;
+    uint32_t i = const_hash(&f->constants[idx]) & mask;
+    while (f->const_index[i] >= 0) i = (i + 1) & mask;
+    f->const_index[i] = idx;
+}
+
+static void const_index_grow(Func* f) {
+    free(f->const_index);
+    f->const_index_capacity = f->const_index_capacity ? f->const_index_capacity * 2 : 64;
+    f->const_index = malloc(sizeof(int) * f->const_index_capacity);
+    for (int i = 0; i < f->const_index_capacity; i++) f->const_index[i] = -1;
+    for (int idx = 0; idx < f->num_constants; idx++) const_index_insert(f, idx);
+}
+
 static int add_const(VM* vm, Value v) {
-    for (int i = 0; i < vm->func.num_constants; i++) {
-        if (vm->func.constants[i].type != v.type) continue;
-        if (v.type == VAL_INT && vm->func.constants[i].i == v.i) return i;
-        if (v.type == VAL_FLOAT && vm->func.constants[i].f == v.f) return i;
-        if (v.type == VAL_STRING && strcmp(vm->func.constants[i].s, v.s) == 0) {
-            if (v.type == VAL_STRING) free(v.s);
-            return i;
+    Func* f = &vm->func;
+    if (f->const_index_capacity) {
+        uint32_t mask = (uint32_t)f->const_index_capacity - 1;
+        for (uint32_t i = const_hash(&v) & mask; f->const_index[i] >= 0; i = (i + 1) & mask) {
+            Value* k = &f->constants[f->const_index[i]];
+            if (k->type == v.type && (v.type == VAL_STRING ? strings_equal(k->s, v.s)
+                                      : v.type == VAL_FLOAT ? k->f == v.f : k->i == v.i)) {
+                // String duplikat tidak direferensikan lagi: sampah GC
+                return f->const_index[i];
+            }
         }
     }
-    int idx = vm->func.num_constants++;
-    vm->func.constants = realloc(vm->func.constants, sizeof(Value) * vm->func.num_constants);
-    vm->func.constants[idx] = v;
+    if (f->num_constants > 0xFFFFFF) {
+        fprintf(stderr, "Error: Terlalu banyak konstanta (maks %d)\n", 0x1000000);
+        exit(1);
+    }
+    if (f->num_constants >= f->const_capacity) {
+        f->const_capacity = f->const_capacity ? f->const_capacity * 2 : 64;
+        f->constants = realloc(f->constants, sizeof(Value) * f->const_capacity);
+    }
+    int idx = f->num_constants++;
+    f->constants[idx] = v;
+    if (f->num_constants * 2 > f->const_index_capacity) const_index_grow(f);
+    else const_index_insert(f, idx);
     return idx;
 }
 
+// === GLOBALS ===
+
+static uint32_t symbol_hash(const char* sym) {
+    // Simbol intern unik per pointer: cukup acak alamatnya
+    return (uint32_t)(((uintptr_t)sym >> 3) * 2654435761u);
+}
+
+static void index_insert(GlobalTable* g, int slot) {
+    uint32_t mask = (uint32_t)g->index_capacity - 1;
+    uint32_t i = symbol_hash(g->names[slot]) & mask;
+    while (g->index[i] >= 0) i = (i + 1) & mask;
+    g->index[i] = slot;
+}
+
+static void index_grow(GlobalTable* g) {
+    free(g->index);
+    g->index_capacity = g->index_capacity ? g->index_capacity * 2 : 64;
+    g->index = malloc(sizeof(int) * g->index_capacity);
+    for (int i = 0; i < g->index_capacity; i++) g->index[i] = -1;
+    for (int slot = 0; slot < g->count; slot++) index_insert(g, slot);
+}
+
+int vm_global_slot(VM* vm, const char* name) {
+    GlobalTable* g = &vm->globals;
+    if (g->index_capacity) {
+        uint32_t mask = (uint32_t)g->index_capacity - 1;
+        for (uint32_t i = symbol_hash(name) & mask; g->index[i] >= 0; i = (i + 1) & mask) {
+            if (g->names[g->index[i]] == name) return g->index[i];
+        }
+    }
+    if (g->count > 0xFFFF) {
+        fprintf(stderr, "Error: Terlalu banyak variabel global (maks 65536)\n");
+        exit(1);
+    }
+    if (g->count >= g->capacity) {
+        g->capacity = g->capacity ? g->capacity * 2 : 64;
+        g->names = realloc(g->names, sizeof(const char*) * g->capacity);
+        g->values = realloc(g->values, sizeof(Value) * g->capacity);
+    }
+    int slot = g->count++;
+    g->names[slot] = name;
+    g->values[slot] = make_nil();
+    if (g->count * 2 > g->index_capacity) index_grow(g);
+    else index_insert(g, slot);
+    return slot;
+}
+
 // === COMPILER ===
 
+// Alokasi register: temporary hidup dari instruksi yang menulisnya sampai
+// instruksi induk yang membacanya, jadi setiap node mencatat `top` =
+// *next_reg saat mulai dan mengembalikannya begitu operand terpakai
+// (hasil memakai ulang register operand pertama). Temporary statement
+// mati di akhir statement, lokal dan blok loop di akhir pernyataan
+// pemiliknya. Register tertinggi dicatat di func.num_regs.
+static int alloc_reg(VM* vm, int* next_reg) {
+    if (*next_reg >= MAX_REGS) {
+        fprintf(stderr, "Error: Register habis (maks %d), ekspresi terlalu dalam\n", MAX_REGS);
+        exit(1);
+    }
+    int r = (*next_reg)++;
+    if (*next_reg > vm->func.num_regs) vm->func.num_regs = *next_reg;
+    return r;
+}
+
 static int comp_node(VM* vm, ASTNode* n, int* next_reg);
+static void comp_operands(VM* vm, ASTNode* x, ASTNode* y, int* l, int* r, int* next_reg);
 
 static int comp_expr(VM* vm, ASTNode* n, int* next_reg) {
     return comp_node(vm, n, next_reg);
 }
 
+// === SUPERINSTRUKSI ===
+// Pola umum digabung menjadi satu instruksi: perbandingan + lompatan
+// (LT_JMP/EQ_JMP), aritmetika dengan konstanta (ADDK/SUBK), dan tambah
+// global (GETGLOBAL_ADD). Operand C hanya 8 bit; bila konstanta/slot
+// global tidak muat, kompilator kembali ke urutan biasa.
+// -DNIRVANA_NO_SUPERINSTR mematikannya untuk pembanding.
+#ifdef NIRVANA_NO_SUPERINSTR
+#define FUSE 0
+#else
+#define FUSE 1
+#endif
+
+// Indeks konstanta (<= 255) bila n literal angka, selain itu -1
+static int const_operand(VM* vm, ASTNode* n) {
+    int k;
+    if (n->type == AST_NUMBER) k = add_const(vm, make_int(n->number));
+    else if (n->type == AST_FLOAT) k = add_const(vm, make_float(n->float_num));
+    else return -1;
+    return k <= 0xFF ? k : -1;
+}
+
+// Slot global (<= 255) bila n identifier global, selain itu -1
+static int local_reg(const char* name);
+static int global_operand(VM* vm, ASTNode* n) {
+    if (n->type != AST_IDENTIFIER || local_reg(n->name) >= 0) return -1;
+    int slot = vm_global_slot(vm, n->name);
+    return slot <= 0xFF ? slot : -1;
+}
+
+// === LOMPATAN ===
+// Offset lompatan biasanya muat di operand instruksinya (8 bit untuk
+// lompatan bersyarat, sBx 16 bit). Lompatan mundur tahu targetnya saat
+// di-emit, jadi langsung memilih bentuk lebar (+EXTRAARG) bila perlu.
+// Lompatan maju baru tahu offsetnya belakangan: bila meluap, pernyataan
+// pemiliknya ditandai lebar dan seluruh program dikompilasi ulang dengan
+// EXTRAARG yang sudah dipesan sejak awal (relaksasi cabang). Himpunan
+// hanya bertambah, jadi pengulangan berhenti; program biasa cukup sekali.
+static struct {
+    ASTNode** nodes;
+    int count, capacity;
+    int overflow;           // ada lompatan maju baru yang meluap
+} wide;
+
+static int is_wide(ASTNode* stmt) {
+    for (int i = 0; i < wide.count; i++)
+        if (wide.nodes[i] == stmt) return 1;
+    return 0;
+}
+
+static void mark_wide(ASTNode* stmt) {
+    wide.overflow = 1;
+    if (is_wide(stmt)) return;
+    if (wide.count >= wide.capacity) {
+        wide.capacity = wide.capacity ? wide.capacity * 2 : 16;
+        wide.nodes = realloc(wide.nodes, sizeof(ASTNode*) * wide.capacity);
+    }
+    wide.nodes[wide.count++] = stmt;
+}
+
+// Offset EXTRAARG untuk lompatan di `at` (EXTRAARG di at+1) ke target
+static Instruction wide_offset(int at, int target) {
+    return MAKE_Ax(OP_EXTRAARG, target - at - 2 + SAX_BIAS);
+}
+
+// Kondisi + lompatan "jika salah" milik `stmt` dengan offset belum diisi;
+// mengembalikan posisi lompatan untuk patch_cond_jump()
+static int comp_cond_jump(VM* vm, ASTNode* stmt, ASTNode* cond, int* next_reg) {
+    int top = *next_reg;
+    int offset = is_wide(stmt) ? JUMP_WIDE_C : 0;
+    if (FUSE && cond->type == AST_BINARY &&
+        (cond->binary.op == TOKEN_LT || cond->binary.op == TOKEN_EQ)) {
+        int l, r;
+        comp_operands(vm, cond->binary.left, cond->binary.right, &l, &r, next_reg);
+        OpCode op = cond->binary.op == TOKEN_LT ? OP_LT_JMP : OP_EQ_JMP;
+        emit(vm, MAKE_ABC(op, l, r, offset));
+    } else {
+        int c = comp_node(vm, cond, next_reg);
+        emit(vm, MAKE_ABC(OP_JMP_IF_NOT, c, offset, 0));
+    }
+    if (offset) emit(vm, MAKE_Ax(OP_EXTRAARG, 0));
+    *next_reg = top;
+    return vm->func.code_size - (offset ? 2 : 1);
+}
+
+// Arahkan lompatan bersyarat di `at` ke code_size. Offset 8 bit ada di B
+// (JMP_IF_NOT) atau C (LT_JMP/EQ_JMP); JUMP_WIDE_C = pakai EXTRAARG.
+static void patch_cond_jump(VM* vm, ASTNode* stmt, int at) {
+    int target = vm->func.code_size;
+    Instruction inst = vm->func.code[at];
+    OpCode op = GET_OP(inst);
+    int field = op == OP_JMP_IF_NOT ? GET_B(inst) : GET_C(inst);
+    if (field == JUMP_WIDE_C) {
+        vm->func.code[at + 1] = wide_offset(at, target);
+        return;
+    }
+    int offset = target - at - 1;
+    if (offset >= JUMP_WIDE_C) {
+        mark_wide(stmt);
+        offset = 0;
+    }
+    if (op == OP_JMP_IF_NOT)
+        vm->func.code[at] = MAKE_ABC(OP_JMP_IF_NOT, GET_A(inst), offset, 0);
+    else
+        vm->func.code[at] = MAKE_ABC(op, GET_A(inst), GET_B(inst), offset);
+}
+
+// Lompatan maju sBx (JMP, FOR_PREP) milik `stmt`; diisi patch_jump()
+static int emit_jump(VM* vm, ASTNode* stmt, OpCode op, int a) {
+    int at = vm->func.code_size;
+    if (is_wide(stmt)) {
+        emit(vm, MAKE_ABx(op, a, (uint16_t)SBX_WIDE));
+        emit(vm, MAKE_Ax(OP_EXTRAARG, 0));
+    } else {
+        emit(vm, MAKE_ABx(op, a, 0));
+    }
+    return at;
+}
+
+static void patch_jump(VM* vm, ASTNode* stmt, int at, int target) {
+    Instruction inst = vm->func.code[at];
+    if (GET_sBx(inst) == SBX_WIDE) {
+        vm->func.code[at + 1] = wide_offset(at, target);
+        return;
+    }
+    int offset = target - at - 1;
+    if (offset > 32767) {
+        mark_wide(stmt);
+        offset = 0;
+    }
+    vm->func.code[at] = MAKE_ABx(GET_OP(inst), GET_A(inst), offset);
+}
+
+// Lompatan mundur sBx (JMP, FOR_LOOP) ke target yang sudah diketahui
+static void emit_back_jump(VM* vm, OpCode op, int a, int target) {
+    int at = vm->func.code_size;
+    int offset = target - at - 1;
+    if (offset > SBX_WIDE) {
+        emit(vm, MAKE_ABx(op, a, (uint16_t)offset));
+    } else {
+        emit(vm, MAKE_ABx(op, a, (uint16_t)SBX_WIDE));
+        emit(vm, wide_offset(at, target));
+    }
+}
+
+// LOADK, atau LOADKX + EXTRAARG bila indeks konstanta melebihi Bx
+static void emit_loadk(VM* vm, int r, int k) {
+    if (k <= 0xFFFF) {
+        emit(vm, MAKE_ABx(OP_LOADK, r, k));
+    } else {
+        emit(vm, MAKE_ABx(OP_LOADKX, r, 0));
+        emit(vm, MAKE_Ax(OP_EXTRAARG, k));
+    }
+}
+
+// === VARIABEL LOKAL ===
+// v0.3 belum punya fungsi, jadi global sejati = nama yang muncul di level
+// teratas program. Nama yang semua kemunculannya ada di dalam satu
+// pernyataan jika/selama/untuk level teratas menjadi lokal pernyataan
+// itu: tinggal di register, dibaca langsung sebagai operand dan ditulis
+// dengan MOVE. Pernyataan level teratas hanya berjalan sekali, jadi
+// LOADNIL di awalnya sama persis dengan global yang belum di-set.
+// Variabel untuk..dalam yang lokal memakai register variabel FOR_LOOP,
+// tanpa SETGLOBAL per putaran. Bila register untuk lokal habis
+// (MAX_LOCAL_REGS), sisanya tetap memakai slot global.
+#define MAX_LOCAL_REGS (MAX_REGS - 64)
+
+typedef struct {
+    const char* name;               // simbol intern
+    ASTNode* owner;                 // pernyataan level teratas, NULL = global
+    int reg;                        // register selama scope aktif, selain itu -1
+} LocalVar;
+
+static struct {
+    LocalVar* vars;
+    int count, capacity;
+    ASTNode* outer;                 // pernyataan level teratas yang sedang dipindai
+    int depth;
+} scopes;
+
+static LocalVar* find_var(const char* name) {
+    for (int i = 0; i < scopes.count; i++) {
+        if (scopes.vars[i].name == name) return &scopes.vars[i];
+    }
+    return NULL;
+}
+
+// Nama yang muncul di luar pemilik pertamanya menjadi global
+static void scope_use(const char* name) {
+    ASTNode* owner = scopes.depth > 0 ? scopes.outer : NULL;
+    LocalVar* v = find_var(name);
+    if (!v) {
+        if (scopes.count >= scopes.capacity) {
+            scopes.capacity = scopes.capacity ? scopes.capacity * 2 : 16;
+            scopes.vars = realloc(scopes.vars, sizeof(LocalVar) * scopes.capacity);
+        }
+        v = &scopes.vars[scopes.count++];
+        v->name = name;
+        v->owner = owner;
+        v->reg = -1;
+        return;
+    }
+    if (v->owner != owner) v->owner = NULL;
+}
+
+static void scan_scopes(ASTNode* n) {
+    if (!n) return;
+    switch (n->type) {
+        case AST_IDENTIFIER: scope_use(n->name); break;
+        case AST_ASSIGN:
+            scope_use(n->assign.name);
+            scan_scopes(n->assign.value);
+            break;
+        case AST_BINARY:
+            scan_scopes(n->binary.left);
+            scan_scopes(n->binary.right);
+            break;
+        case AST_UNARY: scan_scopes(n->unary.operand); break;
+        case AST_INDEX:
+            scan_scopes(n->index.object);
+            scan_scopes(n->index.index);
+            break;
+        case AST_CALL:
+            for (int i = 0; i < n->call.arg_count; i++) scan_scopes(n->call.args[i]);
+            break;
+        case AST_ARRAY:
+            for (int i = 0; i < n->array.count; i++) scan_scopes(n->array.elements[i]);
+            break;
+        case AST_BLOCK:
+            for (int i = 0; i < n->block.count; i++) scan_scopes(n->block.statements[i]);
+            break;
+        case AST_IF:
+        case AST_WHILE:
+        case AST_FOR:
+            if (scopes.depth++ == 0) scopes.outer = n;
+            if (n->type == AST_IF) {
+                scan_scopes(n->if_stmt.condition);
+                scan_scopes(n->if_stmt.then_branch);
+                scan_scopes(n->if_stmt.else_branch);
+            } else if (n->type == AST_WHILE) {
+                scan_scopes(n->while_stmt.condition);
+                scan_scopes(n->while_stmt.body);
+            } else {
+                scope_use(n->for_stmt.var_name);
+                scan_scopes(n->for_stmt.iterable);
+                scan_scopes(n->for_stmt.body);
+            }
+            scopes.depth--;
+            break;
+        default: break;
+    }
+}
+
+static int owns(ASTNode* stmt, LocalVar* v) {
+    return v->owner == stmt;
+}
+
+// Beri register (diisi nil) untuk lokal milik `stmt`, kecuali `skip`
+// yang registernya sudah ditentukan pemanggil
+static void open_scope(VM* vm, ASTNode* stmt, const char* skip, int* next_reg) {
+    for (int i = 0; i < scopes.count; i++) {
+        LocalVar* v = &scopes.vars[i];
+        if (!owns(stmt, v) || v->name == skip) continue;
+        if (*next_reg >= MAX_LOCAL_REGS) continue;   // tetap di slot global
+        v->reg = alloc_reg(vm, next_reg);
+        emit(vm, MAKE_ABC(OP_LOADNIL, v->reg, 0, 0));
+    }
+}
+
+static void close_scope(ASTNode* stmt) {
+    for (int i = 0; i < scopes.count; i++) {
+        if (owns(stmt, &scopes.vars[i])) scopes.vars[i].reg = -1;
+    }
+}
+
+// Register lokal aktif untuk `name`, atau -1 bila global
+static int local_reg(const char* name) {
+    LocalVar* v = find_var(name);
+    return v ? v->reg : -1;
+}
+
+// Tulis hasil ke register lokal. Bila `value` menghasilkan temporary baru
+// (bukan variabel) lewat instruksi terakhir, tujuan instruksi itu diganti
+// langsung sehingga MOVE tidak perlu.
+static void store_local(VM* vm, int local, ASTNode* value, int from, int* next_reg) {
+    if (from == local) return;
+    int fresh = value->type == AST_IDENTIFIER ? local_reg(value->name) < 0
+                                              : value->type != AST_ASSIGN;
+    if (fresh && from == *next_reg - 1 && vm->func.code_size > 0) {
+        Instruction* last = &vm->func.code[vm->func.code_size - 1];
+        switch (GET_OP(*last)) {
+            case OP_LOADK: case OP_LOADBOOL: case OP_LOADNIL: case OP_MOVE:
+            case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_NEG:
+            case OP_EQ: case OP_LT: case OP_NOT: case OP_GETGLOBAL:
+            case OP_NEWARRAY: case OP_GETELEM: case OP_RANGE: case OP_LEN:
+            case OP_ADDK: case OP_SUBK: case OP_GETGLOBAL_ADD:
+                if ((int)GET_A(*last) == from) {
+                    *last = (*last & ~((Instruction)0xFF << 16)) | ((Instruction)local << 16);
+                    return;
+                }
+                break;
+            default: break;
+        }
+    }
+    emit(vm, MAKE_ABC(OP_MOVE, local, from, 0));
+}
+
+// Jumlah register temporary untuk ekspresi tanpa efek samping (label
+// Sethi-Ullman), atau -1 bila ada panggilan/penugasan sehingga urutan
+// kiri-ke-kanan harus dipertahankan. Operand dengan label lebih besar
+// dikompilasi lebih dulu: rantai a + (b + (c + ...)) yang dalam cukup
+// dua register, bukan satu per tingkat (register tetap operand 8 bit).
+static int reg_need(ASTNode* n) {
+    switch (n->type) {
+        case AST_NUMBER: case AST_FLOAT: case AST_STRING: case AST_BOOLEAN:
+        case AST_NULL: case AST_IDENTIFIER:
+            return 1;
+        case AST_UNARY:
+            return reg_need(n->unary.operand);
+        case AST_BINARY:
+        case AST_INDEX: {
+            ASTNode* x = n->type == AST_BINARY ? n->binary.left : n->index.object;
+            ASTNode* y = n->type == AST_BINARY ? n->binary.right : n->index.index;
+            int l = reg_need(x), r = l < 0 ? -1 : reg_need(y);
+            if (r < 0) return -1;
+            return l == r ? l + 1 : (l > r ? l : r);
+        }
+        default: return -1;
+    }
+}
+
+// Kompilasi dua operand ke *l dan *r, yang lebih boros register dulu
+static void comp_operands(VM* vm, ASTNode* x, ASTNode* y, int* l, int* r, int* next_reg) {
+    int nx = reg_need(x);
+    int ny = nx < 0 ? -1 : reg_need(y);
+    if (ny > nx) {
+        *r = comp_node(vm, y, next_reg);
+        *l = comp_node(vm, x, next_reg);
+    } else {
+        *l = comp_node(vm, x, next_reg);
+        *r = comp_node(vm, y, next_reg);
+    }
+}
+
 static int comp_node(VM* vm, ASTNode* n, int* next_reg) {
+    int top = *next_reg;
     switch (n->type) {
         case AST_NUMBER: {
-            int r = (*next_reg)++;
-            emit(vm, MAKE_ABx(OP_LOADK, r, add_const(vm, make_int(n->number))));
+            int r = alloc_reg(vm, next_reg);
+            emit_loadk(vm, r, add_const(vm, make_int(n->number)));
             return r;
         }
         case AST_FLOAT: {
-            int r = (*next_reg)++;
-            emit(vm, MAKE_ABx(OP_LOADK, r, add_const(vm, make_float(n->float_num))));
+            int r = alloc_reg(vm, next_reg);
+            emit_loadk(vm, r, add_const(vm, make_float(n->float_num)));
             return r;
         }
         case AST_STRING: {
-            int r = (*next_reg)++;
-            emit(vm, MAKE_ABx(OP_LOADK, r, add_const(vm, make_string(n->string))));
+            int r = alloc_reg(vm, next_reg);
+            emit_loadk(vm, r, add_const(vm, make_string(vm, n->string)));
             return r;
         }
         case AST_BOOLEAN: {
-            int r = (*next_reg)++;
+            int r = alloc_reg(vm, next_reg);
             emit(vm, MAKE_ABC(OP_LOADBOOL, r, n->boolean, 0));
             return r;
         }
         case AST_NULL: {
-            int r = (*next_reg)++;
+            int r = alloc_reg(vm, next_reg);
             emit(vm, MAKE_ABC(OP_LOADNIL, r, 0, 0));
             return r;
         }
         
         case AST_ARRAY: {
-            int arr_reg = (*next_reg)++;
+            int arr_reg = alloc_reg(vm, next_reg);
             emit(vm, MAKE_ABC(OP_NEWARRAY, arr_reg, 0, 0));
             
             for (int i = 0; i < n->array.count; i++) {
                 int elem_reg = comp_node(vm, n->array.elements[i], next_reg);
                 emit(vm, MAKE_ABC(OP_APPEND, arr_reg, elem_reg, 0));
+                *next_reg = arr_reg + 1;
             }
             return arr_reg;
         }
         
         case AST_IDENTIFIER: {
-            int r = (*next_reg)++;
-            emit(vm, MAKE_ABx(OP_GETGLOBAL, r, add_const(vm, make_string(n->name))));
+            int local = local_reg(n->name);
+            if (local >= 0) return local;
+            int r = alloc_reg(vm, next_reg);
+            emit(vm, MAKE_ABx(OP_GETGLOBAL, r, vm_global_slot(vm, n->name)));
             return r;
         }
         
         case AST_BINARY: {
-            int l = comp_node(vm, n->binary.left, next_reg);
-            int r = comp_node(vm, n->binary.right, next_reg);
-            int res = (*next_reg)++;
+            int tok = n->binary.op;
+            if (FUSE && (tok == TOKEN_PLUS || tok == TOKEN_MINUS)) {
+                int k = const_operand(vm, n->binary.right);
+                if (k >= 0) {
+                    int l = comp_node(vm, n->binary.left, next_reg);
+                    *next_reg = top;
+                    int res = alloc_reg(vm, next_reg);
+                    emit(vm, MAKE_ABC(tok == TOKEN_PLUS ? OP_ADDK : OP_SUBK, res, l, k));
+                    return res;
+                }
+            }
+            if (FUSE && tok == TOKEN_PLUS) {
+                // Penjumlahan angka komutatif: global boleh di kiri atau kanan
+                ASTNode* other = n->binary.left;
+                int g = global_operand(vm, n->binary.right);
+                if (g < 0) {
+                    other = n->binary.right;
+                    g = global_operand(vm, n->binary.left);
+                }
+                // Global dibaca sesudah operand lain dihitung: hanya boleh
+                // bila operand itu tanpa panggilan/penugasan (reg_need >= 0)
+                if (g >= 0 && reg_need(other) >= 0) {
+                    int o = comp_node(vm, other, next_reg);
+                    *next_reg = top;
+                    int res = alloc_reg(vm, next_reg);
+                    emit(vm, MAKE_ABC(OP_GETGLOBAL_ADD, res, o, g));
+                    return res;
+                }
+            }
+            int l, r;
+            comp_operands(vm, n->binary.left, n->binary.right, &l, &r, next_reg);
+            *next_reg = top;
+            int res = alloc_reg(vm, next_reg);
             OpCode op;
             switch (n->binary.op) {
                 case TOKEN_PLUS: op = OP_ADD; break;
@@ -167,34 +727,38 @@ static int comp_node(VM* vm, ASTNode* n, int* next_reg) {
         
         case AST_UNARY: {
             int o = comp_node(vm, n->unary.operand, next_reg);
-            int res = (*next_reg)++;
+            *next_reg = top;
+            int res = alloc_reg(vm, next_reg);
             emit(vm, MAKE_ABC(n->unary.op == TOKEN_MINUS ? OP_NEG : OP_NOT, res, o, 0));
             return res;
         }
         
         case AST_INDEX: {
-            int obj = comp_node(vm, n->index.object, next_reg);
-            int idx = comp_node(vm, n->index.index, next_reg);
-            int res = (*next_reg)++;
+            int obj, idx;
+            comp_operands(vm, n->index.object, n->index.index, &obj, &idx, next_reg);
+            *next_reg = top;
+            int res = alloc_reg(vm, next_reg);
             emit(vm, MAKE_ABC(OP_GETELEM, res, obj, idx));
             return res;
         }
         
         case AST_CALL: {
-            if (strcmp(n->call.name, "cetak") == 0) {
+            if (n->call.name == intern_cstr("cetak")) {
                 int arg = comp_node(vm, n->call.args[0], next_reg);
                 emit(vm, MAKE_ABC(OP_PRINT, arg, 0, 0));
                 return arg;
             }
-            if (strcmp(n->call.name, "range") == 0) {
+            if (n->call.name == intern_cstr("range")) {
                 int end = comp_node(vm, n->call.args[0], next_reg);
-                int res = (*next_reg)++;
+                *next_reg = top;
+                int res = alloc_reg(vm, next_reg);
                 emit(vm, MAKE_ABC(OP_RANGE, res, end, 0));
                 return res;
             }
-            if (strcmp(n->call.name, "panjang") == 0) {
+            if (n->call.name == intern_cstr("panjang")) {
                 int arr = comp_node(vm, n->call.args[0], next_reg);
-                int res = (*next_reg)++;
+                *next_reg = top;
+                int res = alloc_reg(vm, next_reg);
                 emit(vm, MAKE_ABC(OP_LEN, res, arr, 0));
                 return res;
             }
@@ -203,112 +767,94 @@ static int comp_node(VM* vm, ASTNode* n, int* next_reg) {
         
         case AST_ASSIGN: {
             int v = comp_node(vm, n->assign.value, next_reg);
-            emit(vm, MAKE_ABx(OP_SETGLOBAL, v, add_const(vm, make_string(n->assign.name))));
+            int local = local_reg(n->assign.name);
+            if (local >= 0) {
+                store_local(vm, local, n->assign.value, v, next_reg);
+                return local;
+            }
+            emit(vm, MAKE_ABx(OP_SETGLOBAL, v, vm_global_slot(vm, n->assign.name)));
             return v;
         }
         
         case AST_BLOCK: {
             int last = 0;
-            for (int i = 0; i < n->block.count; i++)
+            for (int i = 0; i < n->block.count; i++) {
                 last = comp_node(vm, n->block.statements[i], next_reg);
+                *next_reg = top;
+            }
             return last;
         }
         
         case AST_IF: {
-            int cond = comp_node(vm, n->if_stmt.condition, next_reg);
-            int jmp_not = vm->func.code_size;
-            emit(vm, MAKE_ABC(OP_JMP_IF_NOT, cond, 0, 0));
+            open_scope(vm, n, NULL, next_reg);
+            int jmp_not = comp_cond_jump(vm, n, n->if_stmt.condition, next_reg);
             comp_node(vm, n->if_stmt.then_branch, next_reg);
             if (n->if_stmt.else_branch) {
-                int jmp_end = vm->func.code_size;
-                emit(vm, MAKE_ABx(OP_JMP, 0, 0));
-                // Patch jmp_not
-                int offset = vm->func.code_size - jmp_not;
-                if (offset > 255) offset = 255;
-                vm->func.code[jmp_not] = MAKE_ABC(OP_JMP_IF_NOT, cond, offset, 0);
+                int jmp_end = emit_jump(vm, n, OP_JMP, 0);
+                // Patch jmp_not (offset relatif ke instruksi berikutnya)
+                patch_cond_jump(vm, n, jmp_not);
                 comp_node(vm, n->if_stmt.else_branch, next_reg);
-                // Patch jmp_end
-                offset = vm->func.code_size - jmp_end;
-                if (offset > 65535) offset = 65535;
-                vm->func.code[jmp_end] = MAKE_ABx(OP_JMP, 0, offset);
+                patch_jump(vm, n, jmp_end, vm->func.code_size);
             } else {
-                int offset = vm->func.code_size - jmp_not;
-                if (offset > 255) offset = 255;
-                vm->func.code[jmp_not] = MAKE_ABC(OP_JMP_IF_NOT, cond, offset, 0);
+                patch_cond_jump(vm, n, jmp_not);
             }
-            return cond;
+            close_scope(n);
+            *next_reg = top;
+            return GET_A(vm->func.code[jmp_not]);
         }
         
         case AST_WHILE: {
+            open_scope(vm, n, NULL, next_reg);
             int start = vm->func.code_size;
-            int cond = comp_node(vm, n->while_stmt.condition, next_reg);
-            int jmp_not = vm->func.code_size;
-            emit(vm, MAKE_ABC(OP_JMP_IF_NOT, cond, 0, 0));
+            int jmp_not = comp_cond_jump(vm, n, n->while_stmt.condition, next_reg);
             comp_node(vm, n->while_stmt.body, next_reg);
             // Jump back to start
-            int back_offset = start - vm->func.code_size - 1;
-            if (back_offset < -32768) back_offset = -32768;
-            emit(vm, MAKE_ABx(OP_JMP, 0, (uint16_t)back_offset));
+            emit_back_jump(vm, OP_JMP, 0, start);
             // Patch exit jump
-            int exit_offset = vm->func.code_size - jmp_not;
-            if (exit_offset > 255) exit_offset = 255;
-            vm->func.code[jmp_not] = MAKE_ABC(OP_JMP_IF_NOT, cond, exit_offset, 0);
-            return cond;
+            patch_cond_jump(vm, n, jmp_not);
+            close_scope(n);
+            *next_reg = top;
+            return GET_A(vm->func.code[jmp_not]);
         }
         
         // FIXED: For loop dengan proper iteration
         case AST_FOR: {
-            // Compile iterable first to determine type
+            // Blok register loop: base = iterable, +1 indeks, +2 limit,
+            // +3 step, +4 variabel loop. FOR_PREP mengisi indeks/limit/step
+            // sesuai tipe iterable lalu lompat ke FOR_LOOP; FOR_LOOP
+            // menaikkan, menguji, mengisi variabel, dan lompat ke badan.
+            open_scope(vm, n, n->for_stmt.var_name, next_reg);
             int iter_reg = comp_node(vm, n->for_stmt.iterable, next_reg);
+            int base = iter_reg;
+            // Variabel (lokal) tidak dipakai langsung sebagai base: badan
+            // loop bisa menimpanya selagi FOR_LOOP masih membaca iterable
+            if (iter_reg + 1 != *next_reg || n->for_stmt.iterable->type == AST_IDENTIFIER) {
+                base = alloc_reg(vm, next_reg);
+                emit(vm, MAKE_ABC(OP_MOVE, base, iter_reg, 0));
+            }
+            *next_reg = base + 1;
+            for (int i = 0; i < 4; i++) alloc_reg(vm, next_reg);
+            int var_reg = base + 4;
             
-            // Allocate registers: index, limit, step, var
-            int idx_reg = (*next_reg)++;
-            int limit_reg = (*next_reg)++;
-            int step_reg = (*next_reg)++;
-            int var_reg = (*next_reg)++;
-            int temp_reg = (*next_reg)++;
-            
-            // Initialize index = 0
-            emit(vm, MAKE_ABx(OP_LOADK, idx_reg, add_const(vm, make_int(0))));
-            
-            // Get length of iterable -> limit_reg
-            emit(vm, MAKE_ABC(OP_LEN, limit_reg, iter_reg, 0));
-            
-            // step = 1
-            emit(vm, MAKE_ABx(OP_LOADK, step_reg, add_const(vm, make_int(1))));
-            
-            // Loop start
-            int loop_start = vm->func.code_size;
-            
-            // Check: if idx >= limit, exit
-            // Use LT to test (idx < limit)
-            emit(vm, MAKE_ABC(OP_LT, temp_reg, idx_reg, limit_reg));
-            int jmp_exit = vm->func.code_size;
-            emit(vm, MAKE_ABC(OP_JMP_IF_NOT, temp_reg, 0, 0)); // jump if not (idx < limit)
-            
-            // Get element: var = iterable[idx]
-            emit(vm, MAKE_ABC(OP_GETELEM, var_reg, iter_reg, idx_reg));
-            
-            // Store in global variable
-            emit(vm, MAKE_ABx(OP_SETGLOBAL, var_reg, 
-                add_const(vm, make_string(n->for_stmt.var_name))));
+            int prep = emit_jump(vm, n, OP_FOR_PREP, base);
             
-            // Body
+            // Variabel loop milik loop ini = register variabel FOR_LOOP;
+            // lokal milik pernyataan luar atau global disalin tiap putaran
+            LocalVar* var = find_var(n->for_stmt.var_name);
+            int body_start = vm->func.code_size;
+            int local = local_reg(n->for_stmt.var_name);
+            if (owns(n, var)) var->reg = var_reg;
+            else if (local >= 0) emit(vm, MAKE_ABC(OP_MOVE, local, var_reg, 0));
+            else emit(vm, MAKE_ABx(OP_SETGLOBAL, var_reg, vm_global_slot(vm, n->for_stmt.var_name)));
             comp_node(vm, n->for_stmt.body, next_reg);
             
-            // Increment index
-            emit(vm, MAKE_ABC(OP_ADD, idx_reg, idx_reg, step_reg));
-            
-            // Jump back - FIXED: use MAKE_ABx for signed offset
-            int back_offset = loop_start - vm->func.code_size - 1;
-            if (back_offset < -32768) back_offset = -32768;
-            emit(vm, MAKE_ABx(OP_JMP, 0, (uint16_t)back_offset));
-            
-            // Exit point
-            int exit_offset = vm->func.code_size - jmp_exit;
-            if (exit_offset > 255) exit_offset = 255;
-            vm->func.code[jmp_exit] = MAKE_ABC(OP_JMP_IF_NOT, temp_reg, exit_offset, 0);
+            // FOR_PREP -> FOR_LOOP, FOR_LOOP -> awal body
+            int loop = vm->func.code_size;
+            emit_back_jump(vm, OP_FOR_LOOP, base, body_start);
+            patch_jump(vm, n, prep, loop);
             
+            close_scope(n);
+            *next_reg = top;
             return var_reg;
         }
         
@@ -317,204 +863,291 @@ static int comp_node(VM* vm, ASTNode* n, int* next_reg) {
 }
 
 void vm_compile(VM* vm, ASTNode* ast) {
-    int next_reg = 0;
-    comp_node(vm, ast, &next_reg);
-    emit(vm, MAKE_ABC(OP_HALT, 0, 0, 0));
+    scopes.count = 0;
+    scopes.depth = 0;
+    scopes.outer = NULL;
+    scan_scopes(ast);
+    // Kompilasi ulang selama ada lompatan maju yang baru ditandai lebar;
+    // konstanta dan slot global dari putaran sebelumnya dipakai ulang
+    wide.count = 0;
+    do {
+        wide.overflow = 0;
+        vm->func.code_size = 0;
+        vm->func.num_regs = 0;
+        int next_reg = 0;
+        comp_node(vm, ast, &next_reg);
+        emit(vm, MAKE_ABC(OP_HALT, 0, 0, 0));
+    } while (wide.overflow);
+    free(wide.nodes);
+    wide.nodes = NULL;
+    wide.capacity = 0;
+    free(scopes.vars);
+    scopes.vars = NULL;
+    scopes.capacity = 0;
 }
 
 // === EXECUTION ===
 
+// Dispatch: dengan GCC/Clang (labels-as-values) setiap handler melompat
+// langsung ke handler berikutnya lewat tabel label; compiler lain atau
+// -DNIRVANA_SWITCH_DISPATCH memakai loop switch. Badan handler sama.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(NIRVANA_SWITCH_DISPATCH)
+#define VM_THREADED
+#endif
+
 void vm_run(VM* vm) {
     #define R(i) vm->regs[i]
     #define K(i) vm->func.constants[i]
+    // Operand didekode di handler yang memakainya saja
+    #define A   GET_A(inst)
+    #define B   GET_B(inst)
+    #define C   GET_C(inst)
+    #define BX  GET_Bx(inst)
+    #define SBX GET_sBx(inst)
+    // Lompatan relatif ke instruksi berikutnya; bentuk lebar mengambil
+    // offset dari EXTRAARG (pc menunjuk ke sana) dan melewatinya
+    #define JUMP_WIDE() (pc += GET_sAx(*pc) + 1)
+    #define JUMP_8(off) do { int o_ = (off); if (o_ != JUMP_WIDE_C) pc += o_; else JUMP_WIDE(); } while (0)
+    #define JUMP_SBX() do { int o_ = SBX; if (o_ != SBX_WIDE) pc += o_; else JUMP_WIDE(); } while (0)
     
-    while (vm->pc < vm->func.code_size) {
-        Instruction inst = vm->func.code[vm->pc];
-        OpCode op = GET_OP(inst);
-        int a = GET_A(inst), b = GET_B(inst), c = GET_C(inst);
-        int bx = GET_Bx(inst);
-        int sBx = GET_sBx(inst);  // Signed Bx for jumps
-        
-        switch (op) {
-            case OP_LOADK: R(a) = K(bx); break;
-            case OP_LOADBOOL: R(a) = make_bool(b); break;
-            case OP_LOADNIL: R(a) = make_nil(); break;
-            case OP_MOVE: R(a) = R(b); break;
+    // Kode selalu diakhiri OP_HALT. pc menunjuk instruksi berikutnya,
+    // offset lompatan relatif terhadapnya.
+    const Instruction* pc = vm->func.code;
+    Instruction inst;
+    
+    // -DNIRVANA_COUNT_DISPATCH: hitung instruksi yang didispatch (stderr
+    // saat HALT), untuk membandingkan efek superinstruksi
+#ifdef NIRVANA_COUNT_DISPATCH
+    uint64_t dispatched = 0;
+    #define COUNT_DISPATCH() (dispatched++)
+#else
+    #define COUNT_DISPATCH() ((void)0)
+#endif
+    
+#ifdef VM_THREADED
+    static const void* dispatch[] = {
+        [OP_LOADK] = &&L_OP_LOADK, [OP_LOADBOOL] = &&L_OP_LOADBOOL,
+        [OP_LOADNIL] = &&L_OP_LOADNIL, [OP_MOVE] = &&L_OP_MOVE,
+        [OP_ADD] = &&L_OP_ADD, [OP_SUB] = &&L_OP_SUB, [OP_MUL] = &&L_OP_MUL,
+        [OP_DIV] = &&L_OP_DIV, [OP_MOD] = &&L_unknown, [OP_POW] = &&L_unknown,
+        [OP_NEG] = &&L_OP_NEG,
+        [OP_EQ] = &&L_OP_EQ, [OP_LT] = &&L_OP_LT, [OP_LE] = &&L_unknown, [OP_NE] = &&L_unknown,
+        [OP_AND] = &&L_unknown, [OP_OR] = &&L_unknown, [OP_NOT] = &&L_OP_NOT,
+        [OP_JMP] = &&L_OP_JMP, [OP_JMP_IF] = &&L_unknown, [OP_JMP_IF_NOT] = &&L_OP_JMP_IF_NOT,
+        [OP_CALL] = &&L_unknown, [OP_RETURN] = &&L_unknown,
+        [OP_GETGLOBAL] = &&L_OP_GETGLOBAL, [OP_SETGLOBAL] = &&L_OP_SETGLOBAL,
+        [OP_NEWARRAY] = &&L_OP_NEWARRAY, [OP_GETELEM] = &&L_OP_GETELEM,
+        [OP_SETELEM] = &&L_OP_SETELEM, [OP_APPEND] = &&L_OP_APPEND,
+        [OP_RANGE] = &&L_OP_RANGE, [OP_LEN] = &&L_OP_LEN,
+        [OP_FOR_PREP] = &&L_OP_FOR_PREP, [OP_FOR_LOOP] = &&L_OP_FOR_LOOP,
+        [OP_LT_JMP] = &&L_OP_LT_JMP, [OP_EQ_JMP] = &&L_OP_EQ_JMP,
+        [OP_ADDK] = &&L_OP_ADDK, [OP_SUBK] = &&L_OP_SUBK,
+        [OP_GETGLOBAL_ADD] = &&L_OP_GETGLOBAL_ADD,
+        [OP_LOADKX] = &&L_OP_LOADKX, [OP_EXTRAARG] = &&L_OP_EXTRAARG,
+        [OP_PRINT] = &&L_OP_PRINT, [OP_HALT] = &&L_OP_HALT
+    };
+    #define VM_CASE(op) L_##op:
+    #define VM_DEFAULT  L_unknown:
+    #define VM_NEXT()   do { COUNT_DISPATCH(); inst = *pc++; goto *dispatch[GET_OP(inst)]; } while (0)
+    VM_NEXT();
+    {           // padanan for/switch di bawah: kurung tutupnya dipakai bersama
+        {
+#else
+    #define VM_CASE(op) case op:
+    #define VM_DEFAULT  default:
+    #define VM_NEXT()   continue
+    for (;;) {
+        COUNT_DISPATCH();
+        inst = *pc++;
+        switch (GET_OP(inst)) {
+#endif
+            VM_CASE(OP_LOADK) R(A) = K(BX); VM_NEXT();
+            VM_CASE(OP_LOADKX) R(A) = K(GET_Ax(*pc)); pc++; VM_NEXT();
+            VM_CASE(OP_LOADBOOL) R(A) = make_bool(B); VM_NEXT();
+            VM_CASE(OP_LOADNIL) R(A) = make_nil(); VM_NEXT();
+            VM_CASE(OP_MOVE) R(A) = R(B); VM_NEXT();
             
-            case OP_ADD: {
-                double l, r;
-                to_num(&R(b), &l); to_num(&R(c), &r);
-                if (R(b).type == VAL_INT && R(c).type == VAL_INT)
-                    R(a) = make_int(R(b).i + R(c).i);
-                else R(a) = make_float(l + r);
-                break;
-            }
-            case OP_SUB: {
+            VM_CASE(OP_ADD) num_add(&R(A), &R(B), &R(C)); VM_NEXT();
+            VM_CASE(OP_SUB) num_sub(&R(A), &R(B), &R(C)); VM_NEXT();
+            VM_CASE(OP_ADDK) num_add(&R(A), &R(B), &K(C)); VM_NEXT();
+            VM_CASE(OP_SUBK) num_sub(&R(A), &R(B), &K(C)); VM_NEXT();
+            VM_CASE(OP_GETGLOBAL_ADD) num_add(&R(A), &R(B), &vm->globals.values[C]); VM_NEXT();
+            VM_CASE(OP_MUL) {
                 double l, r;
-                to_num(&R(b), &l); to_num(&R(c), &r);
-                if (R(b).type == VAL_INT && R(c).type == VAL_INT)
-                    R(a) = make_int(R(b).i - R(c).i);
-                else R(a) = make_float(l - r);
-                break;
+                to_num(&R(B), &l); to_num(&R(C), &r);
+                if (R(B).type == VAL_INT && R(C).type == VAL_INT)
+                    R(A) = make_int(R(B).i * R(C).i);
+                else R(A) = make_float(l * r);
+                VM_NEXT();
             }
-            case OP_MUL: {
+            VM_CASE(OP_DIV) {
                 double l, r;
-                to_num(&R(b), &l); to_num(&R(c), &r);
-                if (R(b).type == VAL_INT && R(c).type == VAL_INT)
-                    R(a) = make_int(R(b).i * R(c).i);
-                else R(a) = make_float(l * r);
-                break;
+                to_num(&R(B), &l); to_num(&R(C), &r);
+                R(A) = make_float(l / r);
+                VM_NEXT();
             }
-            case OP_DIV: {
-                double l, r;
-                to_num(&R(b), &l); to_num(&R(c), &r);
-                R(a) = make_float(l / r);
-                break;
-            }
-            case OP_NEG: {
-                double v; to_num(&R(b), &v);
-                if (R(b).type == VAL_INT) R(a) = make_int(-R(b).i);
-                else R(a) = make_float(-v);
-                break;
+            VM_CASE(OP_NEG) {
+                double v; to_num(&R(B), &v);
+                if (R(B).type == VAL_INT) R(A) = make_int(-R(B).i);
+                else R(A) = make_float(-v);
+                VM_NEXT();
             }
             
-            case OP_EQ: {
-                int eq = 0;
-                if (R(b).type == R(c).type) {
-                    if (R(b).type == VAL_INT) eq = R(b).i == R(c).i;
-                    else if (R(b).type == VAL_FLOAT) eq = R(b).f == R(c).f;
-                    else if (R(b).type == VAL_STRING) eq = strcmp(R(b).s, R(c).s) == 0;
+            VM_CASE(OP_EQ) R(A) = make_bool(values_equal(&R(B), &R(C))); VM_NEXT();
+            VM_CASE(OP_LT) R(A) = make_bool(num_less(&R(B), &R(C))); VM_NEXT();
+            VM_CASE(OP_NOT) R(A) = make_bool(!is_truthy(&R(B))); VM_NEXT();
+            
+            VM_CASE(OP_JMP) JUMP_SBX(); VM_NEXT();
+            VM_CASE(OP_JMP_IF_NOT) if (!is_truthy(&R(A))) JUMP_8(B); VM_NEXT();
+            // Bandingkan lalu lompat tanpa menulis boolean ke register
+            VM_CASE(OP_LT_JMP) if (!num_less(&R(A), &R(B))) JUMP_8(C); VM_NEXT();
+            VM_CASE(OP_EQ_JMP) if (!values_equal(&R(A), &R(B))) JUMP_8(C); VM_NEXT();
+            // Tidak dilompati: EXTRAARG dieksekusi sebagai nop
+            VM_CASE(OP_EXTRAARG) VM_NEXT();
+            
+            // Range: indeks = nilai itu sendiri. Array: indeks posisi, limit
+            // = ukuran saat loop dimulai (elemen tidak pernah dihapus), jadi
+            // FOR_LOOP membaca data[i] tanpa cek batas. Tipe lain: 0 putaran.
+            VM_CASE(OP_FOR_PREP) {
+                Value* base = &R(A);
+                int64_t start = 0, limit = 0, step = 1;
+                if (base->type == VAL_RANGE) {
+                    start = base->r.start;
+                    limit = base->r.end;
+                    step = base->r.step;
+                } else if (base->type == VAL_ARRAY) {
+                    limit = base->a->size;
                 }
-                R(a) = make_bool(eq);
-                break;
+                base[1] = make_int(start - step);
+                base[2] = make_int(limit);
+                base[3] = make_int(step);
+                JUMP_SBX();
+                VM_NEXT();
             }
-            case OP_LT: {
-                double l, r; to_num(&R(b), &l); to_num(&R(c), &r);
-                R(a) = make_bool(l < r);
-                break;
+            VM_CASE(OP_FOR_LOOP) {
+                Value* base = &R(A);
+                int64_t i = base[1].i + base[3].i;
+                if (base[3].i > 0 ? i < base[2].i : i > base[2].i) {
+                    base[1].i = i;
+                    if (base->type == VAL_ARRAY) {
+                        base[4] = base->a->data[i];
+                    } else {
+                        base[4].i = i;
+                        base[4].type = VAL_INT;
+                    }
+                    JUMP_SBX();
+                }
+                VM_NEXT();
             }
-            case OP_NOT: R(a) = make_bool(!is_truthy(&R(b))); break;
             
-            // FIXED: Use sBx (signed) for JMP
-            case OP_JMP: vm->pc += sBx; continue;
-            case OP_JMP_IF_NOT: if (!is_truthy(&R(a))) { vm->pc += b; continue; } break;
-            
-            case OP_NEWARRAY: {
-                R(a) = make_array();
-                break;
+            VM_CASE(OP_NEWARRAY) {
+                R(A) = make_array(vm);
+                VM_NEXT();
             }
-            case OP_APPEND: {
-                if (R(a).type == VAL_ARRAY) {
-                    array_append(&R(a).a, R(b));
+            VM_CASE(OP_APPEND) {
+                if (R(A).type == VAL_ARRAY) {
+                    array_append(vm, R(A).a, R(B));
                 }
-                break;
+                VM_NEXT();
             }
             // FIXED: OP_GETELEM untuk range mengembalikan nilai aktual
-            case OP_GETELEM: {
-                if (R(b).type == VAL_ARRAY && R(c).type == VAL_INT) {
-                    int idx = (int)R(c).i;
-                    if (idx >= 0 && idx < R(b).a.size) {
-                        R(a) = R(b).a.data[idx];
+            VM_CASE(OP_GETELEM) {
+                if (R(B).type == VAL_ARRAY && R(C).type == VAL_INT) {
+                    int idx = (int)R(C).i;
+                    if (idx >= 0 && idx < R(B).a->size) {
+                        R(A) = R(B).a->data[idx];
                     } else {
-                        R(a) = make_nil();
+                        R(A) = make_nil();
                     }
-                } else if (R(b).type == VAL_RANGE && R(c).type == VAL_INT) {
-                    int idx = (int)R(c).i;
+                } else if (R(B).type == VAL_RANGE && R(C).type == VAL_INT) {
+                    int idx = (int)R(C).i;
                     // FIXED: Return actual value at index
-                    int val = R(b).r.start + idx * R(b).r.step;
-                    if (val < R(b).r.end) {
-                        R(a) = make_int(val);
+                    int val = R(B).r.start + idx * R(B).r.step;
+                    if (val < R(B).r.end) {
+                        R(A) = make_int(val);
                     } else {
-                        R(a) = make_nil();
+                        R(A) = make_nil();
                     }
                 } else {
-                    R(a) = make_nil();
+                    R(A) = make_nil();
                 }
-                break;
+                VM_NEXT();
             }
-            case OP_SETELEM: {
-                if (R(a).type == VAL_ARRAY && R(b).type == VAL_INT) {
-                    int idx = (int)R(b).i;
-                    if (idx >= 0 && idx < R(a).a.size) {
-                        R(a).a.data[idx] = R(c);
+            VM_CASE(OP_SETELEM) {
+                if (R(A).type == VAL_ARRAY && R(B).type == VAL_INT) {
+                    int idx = (int)R(B).i;
+                    if (idx >= 0 && idx < R(A).a->size) {
+                        R(A).a->data[idx] = R(C);
                     }
                 }
-                break;
+                VM_NEXT();
             }
-            case OP_RANGE: {
-                R(a).type = VAL_RANGE;
-                R(a).r.start = 0;
-                R(a).r.end = (R(b).type == VAL_INT) ? R(b).i : 0;
-                R(a).r.step = 1;
-                break;
+            VM_CASE(OP_RANGE) {
+                int end = (R(B).type == VAL_INT) ? R(B).i : 0;  // A boleh sama dengan B
+                R(A).type = VAL_RANGE;
+                R(A).r.start = 0;
+                R(A).r.end = end;
+                R(A).r.step = 1;
+                VM_NEXT();
             }
             // FIXED: OP_LEN untuk range
-            case OP_LEN: {
-                if (R(b).type == VAL_ARRAY) {
-                    R(a) = make_int(R(b).a.size);
-                } else if (R(b).type == VAL_STRING) {
-                    R(a) = make_int(strlen(R(b).s));
-                } else if (R(b).type == VAL_RANGE) {
+            VM_CASE(OP_LEN) {
+                if (R(B).type == VAL_ARRAY) {
+                    R(A) = make_int(R(B).a->size);
+                } else if (R(B).type == VAL_STRING) {
+                    R(A) = make_int(R(B).s->length);
+                } else if (R(B).type == VAL_RANGE) {
                     // Calculate number of elements in range
-                    int count = (R(b).r.end - R(b).r.start + R(b).r.step - 1) / R(b).r.step;
+                    int count = (R(B).r.end - R(B).r.start + R(B).r.step - 1) / R(B).r.step;
                     if (count < 0) count = 0;
-                    R(a) = make_int(count);
+                    R(A) = make_int(count);
                 } else {
-                    R(a) = make_int(0);
+                    R(A) = make_int(0);
                 }
-                break;
+                VM_NEXT();
             }
             
-            case OP_GETGLOBAL: {
-                char* name = K(bx).s;
-                int found = 0;
-                for (int i = 0; i < vm->num_globals; i++) {
-                    if (strcmp(vm->globals[i].name, name) == 0) {
-                        R(a) = vm->globals[i].val; 
-                        found = 1;
-                        break;
-                    }
-                }
-                if (!found) {
-                    R(a) = make_nil();  // Return nil if not found
-                }
-                break;
-            }
-            case OP_SETGLOBAL: {
-                char* name = K(bx).s;
-                int found = 0;
-                for (int i = 0; i < vm->num_globals; i++) {
-                    if (strcmp(vm->globals[i].name, name) == 0) {
-                        vm->globals[i].val = R(a); found = 1; break;
-                    }
-                }
-                if (!found) {
-                    int idx = vm->num_globals++;
-                    vm->globals[idx].name = strdup(name);
-                    vm->globals[idx].val = R(a);
-                }
-                break;
-            }
+            // Global yang belum di-set bernilai nil (slot diisi nil saat dibuat)
+            VM_CASE(OP_GETGLOBAL) R(A) = vm->globals.values[BX]; VM_NEXT();
+            VM_CASE(OP_SETGLOBAL) vm->globals.values[BX] = R(A); VM_NEXT();
             
-            case OP_PRINT:
-                switch (R(a).type) {
-                    case VAL_INT: printf("%ld\n", R(a).i); break;
-                    case VAL_FLOAT: printf("%g\n", R(a).f); break;
-                    case VAL_STRING: printf("%s\n", R(a).s); break;
-                    case VAL_BOOL: printf("%s\n", R(a).i ? "true" : "false"); break;
-                    case VAL_ARRAY: printf("[array:%d]\n", R(a).a.size); break;
+            VM_CASE(OP_PRINT)
+                switch (R(A).type) {
+                    case VAL_INT: printf("%ld\n", R(A).i); break;
+                    case VAL_FLOAT: printf("%g\n", R(A).f); break;
+                    case VAL_STRING: printf("%s\n", R(A).s->chars); break;
+                    case VAL_BOOL: printf("%s\n", R(A).i ? "true" : "false"); break;
+                    case VAL_ARRAY: printf("[array:%d]\n", R(A).a->size); break;
                     default: printf("nil\n");
                 }
-                break;
+                VM_NEXT();
                 
-            case OP_HALT: return;
+            VM_CASE(OP_HALT)
+                vm->pc = (int)(pc - 1 - vm->func.code);
+#ifdef NIRVANA_COUNT_DISPATCH
+                fprintf(stderr, "[dispatch] %llu instruksi\n", (unsigned long long)dispatched);
+#endif
+                return;
             
-            default: break;
+            // Opcode yang belum punya handler dilewati
+            VM_DEFAULT
+                VM_NEXT();
         }
-        vm->pc++;
     }
     #undef R
     #undef K
+    #undef A
+    #undef B
+    #undef C
+    #undef BX
+    #undef SBX
+    #undef JUMP_WIDE
+    #undef JUMP_8
+    #undef JUMP_SBX
+    #undef VM_CASE
+    #undef VM_DEFAULT
+    #undef VM_NEXT
+    #undef COUNT_DISPATCH
 }
 
 static const char* op_names[] = {
@@ -522,27 +1155,48 @@ static const char* op_names[] = {
     "EQ","LT","LE","NE","AND","OR","NOT","JMP","JMP_IF","JMP_IF_NOT",
     "CALL","RETURN","GETGLOBAL","SETGLOBAL",
     "NEWARRAY","GETELEM","SETELEM","APPEND","RANGE","LEN",
-    "FOR_PREP","FOR_LOOP","PRINT","HALT"
+    "FOR_PREP","FOR_LOOP",
+    "LT_JMP","EQ_JMP","ADDK","SUBK","GETGLOBAL_ADD",
+    "LOADKX","EXTRAARG",
+    "PRINT","HALT"
 };
 
 void vm_print_bytecode(VM* vm) {
-    printf("\n=== BYTECODE ===\n");
+    printf("\n=== BYTECODE (%d register) ===\n", vm->func.num_regs);
     for (int i = 0; i < vm->func.num_constants; i++) {
         printf("K[%d] = ", i);
         if (vm->func.constants[i].type == VAL_INT) printf("%ld\n", vm->func.constants[i].i);
         else if (vm->func.constants[i].type == VAL_FLOAT) printf("%g\n", vm->func.constants[i].f);
-        else if (vm->func.constants[i].type == VAL_STRING) printf("\"%s\"\n", vm->func.constants[i].s);
+        else if (vm->func.constants[i].type == VAL_STRING) printf("\"%s\"\n", vm->func.constants[i].s->chars);
     }
     printf("\n");
     for (int i = 0; i < vm->func.code_size; i++) {
         Instruction inst = vm->func.code[i];
         OpCode op = GET_OP(inst);
-        if (op < 35) {
+        if ((size_t)op < sizeof(op_names) / sizeof(op_names[0])) {
             printf("%04d: %-12s ", i, op_names[op]);
-            if (op == OP_LOADK || op == OP_GETGLOBAL || op == OP_SETGLOBAL)
+            if (op == OP_LOADK)
                 printf("R%d, K%d\n", GET_A(inst), GET_Bx(inst));
-            else if (op == OP_JMP || op == OP_JMP_IF_NOT)
-                printf("%+d\n", (int16_t)GET_Bx(inst));
+            else if (op == OP_GETGLOBAL || op == OP_SETGLOBAL)
+                printf("R%d, %s\n", GET_A(inst), vm->globals.names[GET_Bx(inst)]);
+            else if (op == OP_LOADKX)
+                printf("R%d\n", GET_A(inst));
+            else if (op == OP_EXTRAARG && i > 0 && GET_OP(vm->func.code[i - 1]) == OP_LOADKX)
+                printf("K%d\n", GET_Ax(inst));
+            else if (op == OP_EXTRAARG)
+                printf("%+d\n", GET_sAx(inst));
+            else if (op == OP_JMP)
+                printf("%+d\n", GET_sBx(inst));
+            else if (op == OP_FOR_PREP || op == OP_FOR_LOOP)
+                printf("R%d, %+d\n", GET_A(inst), GET_sBx(inst));
+            else if (op == OP_JMP_IF_NOT)
+                printf("R%d, %+d\n", GET_A(inst), GET_B(inst));
+            else if (op == OP_LT_JMP || op == OP_EQ_JMP)
+                printf("R%d, R%d, %+d\n", GET_A(inst), GET_B(inst), GET_C(inst));
+            else if (op == OP_ADDK || op == OP_SUBK)
+                printf("R%d, R%d, K%d\n", GET_A(inst), GET_B(inst), GET_C(inst));
+            else if (op == OP_GETGLOBAL_ADD)
+                printf("R%d, R%d, %s\n", GET_A(inst), GET_B(inst), vm->globals.names[GET_C(inst)]);
             else
                 printf("R%d, R%d, R%d\n", GET_A(inst), GET_B(inst), GET_C(inst));
         } else {
@@ -2,6 +2,7 @@
 #define VM_H
 
 #include "parser.h"
+#include <stddef.h>
 #include <stdint.h>
 
 #define MAX_REGS 256
@@ -20,7 +21,28 @@ typedef enum {
 // Forward declaration
 struct Value;
 
+// Header objek heap (string, array) yang dikelola GC (gc.c). Semua
+// objek tertaut di Heap.objects; header selalu di awal struct.
+typedef struct GCObject {
+    struct GCObject* next;
+    uint8_t type;           // VAL_STRING / VAL_ARRAY
+    uint8_t marked;
+} GCObject;
+
+// String tidak bisa diubah: panjang disimpan (len O(1)) dan hash
+// dihitung sekali saat pertama dibutuhkan (string_hash di vm.c), jadi
+// perbandingan bisa menolak lewat panjang/hash sebelum membandingkan
+// byte, dan indeks konstanta tidak meng-hash ulang.
+typedef struct {
+    GCObject gc;
+    int length;
+    uint32_t hash;          // 0 = belum dihitung
+    char chars[];           // diakhiri '\0'
+} String;
+
+// Array adalah objek referensi: menyalin Value hanya menyalin pointer
 typedef struct {
+    GCObject gc;
     struct Value* data;
     int size;
     int capacity;
@@ -37,8 +59,8 @@ typedef struct Value {
     union {
         int64_t i;
         double f;
-        char* s;
-        Array a;        // NEW
+        String* s;
+        Array* a;       // NEW
         Range r;        // NEW
     };
 } Value;
@@ -59,9 +81,20 @@ typedef enum {
     OP_RANGE,       // Create range object
     OP_LEN,         // Get length
     
-    // NEW: For loop
-    OP_FOR_PREP,    // Prepare for loop
-    OP_FOR_LOOP,    // Loop iteration
+    // For loop, blok R(A)..R(A+4) = iterable, indeks, limit, step, var
+    OP_FOR_PREP,    // siapkan indeks/limit/step; pc += sBx (ke FOR_LOOP)
+    OP_FOR_LOOP,    // indeks += step; jika masih < limit: isi var, pc += sBx
+    
+    // Superinstruksi (dipilih kompilator, lihat NIRVANA_NO_SUPERINSTR)
+    OP_LT_JMP,      // if !(R(A) < R(B)) pc += C
+    OP_EQ_JMP,      // if !(R(A) == R(B)) pc += C
+    OP_ADDK,        // R(A) = R(B) + K(C)
+    OP_SUBK,        // R(A) = R(B) - K(C)
+    OP_GETGLOBAL_ADD, // R(A) = R(B) + G[C]
+    
+    // Format lebar: operand yang tidak muat disimpan di EXTRAARG berikutnya
+    OP_LOADKX,      // R(A) = K(Ax EXTRAARG)
+    OP_EXTRAARG,    // Ax 24 bit untuk instruksi sebelumnya; sendiri = nop
     
     OP_PRINT, OP_HALT
 } OpCode;
@@ -75,31 +108,74 @@ typedef uint32_t Instruction;
 #define GET_sBx(i) ((int16_t)((i) & 0xFFFF))
 #define MAKE_ABC(op,a,b,c) (((op)<<24)|((a)<<16)|((b)<<8)|(c))
 #define MAKE_ABx(op,a,bx) (((op)<<24)|((a)<<16)|(bx))
+#define GET_Ax(i) ((i) & 0xFFFFFF)
+#define GET_sAx(i) ((int)GET_Ax(i) - SAX_BIAS)
+#define MAKE_Ax(op,ax) (((op)<<24)|((ax) & 0xFFFFFF))
+
+// Lompatan lebar. Offset 8 bit (B JMP_IF_NOT, C LT_JMP/EQ_JMP) bernilai
+// JUMP_WIDE_C atau sBx (JMP/FOR_PREP/FOR_LOOP) bernilai SBX_WIDE berarti
+// offset sebenarnya = sAx EXTRAARG berikutnya, relatif ke instruksi
+// setelah EXTRAARG. Konstanta > 0xFFFF dimuat dengan LOADKX.
+#define JUMP_WIDE_C 0xFF
+#define SBX_WIDE (-32768)
+#define SAX_BIAS 0x7FFFFF
 
 typedef struct {
     Value* constants;
-    int num_constants;
+    int num_constants, const_capacity;
+    int* const_index;       // open addressing: hash nilai -> indeks, -1 = kosong
+    int const_index_capacity;
     Instruction* code;
     int code_size, code_capacity;
+    int num_regs;           // register tertinggi yang dipakai + 1
 } Func;
 
+// Global di-resolve ke slot padat saat kompilasi: Bx GETGLOBAL/SETGLOBAL
+// adalah indeks values[]. Indeks hash simbol -> slot hanya dipakai
+// kompilator dan tumbuh bersama tabel (tidak ada batas 256 lagi).
+typedef struct {
+    const char** names;     // slot -> simbol intern
+    Value* values;          // nil sampai SETGLOBAL pertama
+    int count;
+    int capacity;
+    int* index;             // open addressing: simbol -> slot, -1 = kosong
+    int index_capacity;     // pangkat dua, terisi maksimal setengah
+} GlobalTable;
+
+// Heap GC: koleksi dipicu alokasi begitu `bytes` melewati `next_gc`,
+// lalu ambang diset ke GC_HEAP_GROW x heap yang masih hidup.
+typedef struct {
+    GCObject* objects;
+    size_t bytes;           // header + payload semua objek
+    size_t next_gc;
+    GCObject** gray;        // array yang sudah ditandai, isinya belum
+    int gray_count, gray_capacity;
+    // Statistik (dicetak dengan -DNIRVANA_GC_STATS)
+    int collections;
+    size_t objects_allocated, objects_freed;
+    size_t bytes_freed, peak_bytes;
+    double pause_total_ms, pause_max_ms;
+} Heap;
+
 typedef struct {
     Func func;
     Value regs[MAX_REGS];
     int pc;
-    struct { char* name; Value val; } globals[256];
-    int num_globals;
+    GlobalTable globals;
+    Heap heap;
 } VM;
 
 VM* vm_create(void);
 void vm_destroy(VM* vm);
 void vm_compile(VM* vm, ASTNode* ast);
+// Slot global untuk simbol intern `name`; dibuat bila belum ada.
+int vm_global_slot(VM* vm, const char* name);
 void vm_run(VM* vm);
 void vm_print_bytecode(VM* vm);
 
 // Helper functions
-Value make_array(void);
-void array_append(Array* arr, Value v);
+Value make_array(VM* vm);
+void array_append(VM* vm, Array* arr, Value v);
 Value array_get(Array* arr, int idx);
 void array_set(Array* arr, int idx, Value v);
 